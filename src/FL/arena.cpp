@@ -0,0 +1,18 @@
+#include "arena.h"
+
+namespace FL {
+
+Arena::Arena(size_t init_size)
+    : m_buffer(new char[init_size])
+    , m_initSize(init_size)
+    , m_resource(m_buffer.get(), init_size, std::pmr::new_delete_resource())
+    , m_allocated(0) {
+}
+
+void Arena::reset() {
+    // release后重新从初始缓冲区开始分配
+    m_resource.release();
+    m_allocated = 0;
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "noncopyable.h"
+
+namespace FL {
+
+/**
+ * @brief 单调分配的内存池, 只分配不释放, reset时一次性回收
+ *
+ * @details 基于std::pmr::monotonic_buffer_resource, 自带一块初始缓冲区,
+ *          reset后重新从初始缓冲区开始分配, 用量不超过初始缓冲区时不访问全局堆.
+ *          不是线程安全的, 适合一个连接内逐个处理请求的场景
+ */
+class Arena : public std::enable_shared_from_this<Arena>, NonCopyable {
+  public:
+    typedef std::shared_ptr<Arena> ptr;
+
+    /**
+     * @param[in] init_size 初始缓冲区大小, 超出后按块从全局堆扩充
+     */
+    Arena(size_t init_size = 8 * 1024);
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        m_allocated += size;
+        return m_resource.allocate(size, align);
+    }
+
+    /**
+     * @brief 回收全部内存, 之前分配的对象必须都已销毁
+     */
+    void reset();
+
+    std::pmr::memory_resource* getResource() {
+        return &m_resource;
+    }
+
+    // 自上次reset以来分配的字节数
+    uint64_t getAllocated() const {
+        return m_allocated;
+    }
+    size_t getInitSize() const {
+        return m_initSize;
+    }
+
+    /**
+     * @brief 在arena中创建对象, 对象和shared_ptr控制块一次分配
+     *
+     * @details 控制块持有arena的引用, 对象在arena之外被继续持有时arena不会被析构;
+     *          此时调用方应换用新的arena而不是reset
+     */
+    template <class T, class... Args>
+    std::shared_ptr<T> makeShared(Args&&... args);
+  private:
+    std::unique_ptr<char[]> m_buffer;                   // 初始缓冲区
+    size_t m_initSize;
+    std::pmr::monotonic_buffer_resource m_resource;
+    uint64_t m_allocated;
+};
+
+/**
+ * @brief 从Arena分配的STL分配器, 持有arena的引用, deallocate不做任何事
+ */
+template <class T>
+class ArenaAllocator {
+  public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena::ptr arena)
+        : m_arena(std::move(arena)) {
+    }
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+        : m_arena(other.getArena()) {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) {
+    }
+
+    const Arena::ptr& getArena() const {
+        return m_arena;
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& rhs) const {
+        return m_arena == rhs.getArena();
+    }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& rhs) const {
+        return m_arena != rhs.getArena();
+    }
+  private:
+    Arena::ptr m_arena;
+};
+
+template <class T, class... Args>
+std::shared_ptr<T> Arena::makeShared(Args&&... args) {
+    return std::allocate_shared<T>(ArenaAllocator<T>(shared_from_this())
+                                   , std::forward<Args>(args)...);
+}
+
+}
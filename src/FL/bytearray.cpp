@@ -1,30 +1,220 @@
 #include "bytearray.h"
+#include "checksum.h"
 #include "endian.h"
 #include "logmanager.h"
+#include "macro.h"
 #include "ScopeGuard.hpp"
 #include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <stdexcept>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace FL {
 
+namespace {
+
+// 池化的内存块按2的幂分级, 最小256字节, 最大64KB, 更大的块直接new/delete
+static constexpr size_t s_pool_min_shift = 8;
+static constexpr size_t s_pool_max_shift = 16;
+static constexpr size_t s_pool_classes = s_pool_max_shift - s_pool_min_shift + 1;
+// 每个线程每一级最多缓存的字节数
+static constexpr size_t s_pool_cache_bytes = 1 << 20;
+
+static std::atomic<bool>     s_pool_enabled{true};
+static std::atomic<uint64_t> s_pool_footprint{0};
+static std::atomic<uint64_t> s_pool_peak{0};
+
+static size_t PoolClass(size_t size) {
+    size_t idx = 0;
+    while(((size_t)1 << (idx + s_pool_min_shift)) < size) {
+        ++idx;
+    }
+    return idx;
+}
+
+static size_t PoolClassSize(size_t idx) {
+    return (size_t)1 << (idx + s_pool_min_shift);
+}
+
+static void AddFootprint(size_t bytes) {
+    uint64_t cur = s_pool_footprint.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = s_pool_peak.load(std::memory_order_relaxed);
+    while(cur > peak && !s_pool_peak.compare_exchange_weak(peak, cur, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 线程私有的内存块池
+ *
+ * @details 块释放到释放时所在线程的池中, 不需要加锁;
+ *          线程退出时缓存的块全部归还给系统
+ */
+class BlockPool {
+  public:
+    ~BlockPool() {
+        s_dead = true;
+        for(size_t i = 0; i < s_pool_classes; ++i) {
+            for(auto& mem : m_free[i]) {
+                delete[] mem;
+            }
+            s_pool_footprint.fetch_sub(m_free[i].size() * (sizeof(ByteArray::Block) + PoolClassSize(i))
+                                       , std::memory_order_relaxed);
+        }
+    }
+
+    char* alloc(size_t idx) {
+        auto& list = m_free[idx];
+        if(!list.empty()) {
+            char* mem = list.back();
+            list.pop_back();
+            ++m_hits;
+            return mem;
+        }
+        ++m_misses;
+        AddFootprint(sizeof(ByteArray::Block) + PoolClassSize(idx));
+        return new char[sizeof(ByteArray::Block) + PoolClassSize(idx)];
+    }
+
+    void free(size_t idx, char* mem) {
+        auto& list = m_free[idx];
+        if(list.size() * PoolClassSize(idx) >= s_pool_cache_bytes) {
+            s_pool_footprint.fetch_sub(sizeof(ByteArray::Block) + PoolClassSize(idx), std::memory_order_relaxed);
+            delete[] mem;
+            return;
+        }
+        list.push_back(mem);
+    }
+
+    uint64_t getHits() const {
+        return m_hits;
+    }
+    uint64_t getMisses() const {
+        return m_misses;
+    }
+
+    static BlockPool* GetThis() {
+        static thread_local BlockPool s_pool;
+        return s_dead ? nullptr : &s_pool;
+    }
+  private:
+    std::vector<char*> m_free[s_pool_classes];	// 每一级的空闲块
+    uint64_t m_hits = 0;						// 命中次数
+    uint64_t m_misses = 0;						// 未命中次数
+
+    static thread_local bool s_dead;			// 线程退出时池已析构
+};
+
+thread_local bool BlockPool::s_dead = false;
+
+static void FreeBlock(ByteArray::Block* block) {
+    block->~Block();
+    delete[] (char*)block;
+}
+
+static void FreePooledBlock(ByteArray::Block* block) {
+    size_t idx = PoolClass(block->size);
+    block->~Block();
+    BlockPool* pool = BlockPool::GetThis();
+    if(pool) {
+        pool->free(idx, (char*)block);
+    } else {
+        s_pool_footprint.fetch_sub(sizeof(ByteArray::Block) + PoolClassSize(idx), std::memory_order_relaxed);
+        delete[] (char*)block;
+    }
+}
+
+}
+
+ByteArray::Block* ByteArray::Block::Create(size_t size) {
+    char* mem = nullptr;
+    void (*release)(Block*) = &FreeBlock;
+    BlockPool* pool = nullptr;
+    if(size <= PoolClassSize(s_pool_classes - 1)
+            && s_pool_enabled.load(std::memory_order_relaxed)
+            && (pool = BlockPool::GetThis())) {
+        mem = pool->alloc(PoolClass(size));
+        release = &FreePooledBlock;
+    } else {
+        mem = new char[sizeof(Block) + size];
+    }
+    Block* block = new (mem) Block;
+    block->data = mem + sizeof(Block);
+    block->size = size;
+    block->count.store(1, std::memory_order_relaxed);
+    block->release = release;
+    block->readonly = false;
+    return block;
+}
+
+ByteArray::PoolStats ByteArray::GetPoolStats() {
+    PoolStats stats;
+    BlockPool* pool = BlockPool::GetThis();
+    stats.hits = pool ? pool->getHits() : 0;
+    stats.misses = pool ? pool->getMisses() : 0;
+    stats.footprint = s_pool_footprint.load(std::memory_order_relaxed);
+    stats.peak = s_pool_peak.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ByteArray::SetPoolEnabled(bool v) {
+    s_pool_enabled.store(v, std::memory_order_relaxed);
+}
+
+bool ByteArray::IsPoolEnabled() {
+    return s_pool_enabled.load(std::memory_order_relaxed);
+}
+
 ByteArray::Node::Node(size_t size)
-    : ptr(new char[size])
+    : ptr(nullptr)
     , size(size)
-    , next(nullptr) {
+    , next(nullptr)
+    , block(Block::Create(size)) {
+    ptr = block->data;
+}
+
+ByteArray::Node::Node(Block* block, char* ptr, size_t size)
+    : ptr(ptr)
+    , size(size)
+    , next(nullptr)
+    , block(block) {
+    block->ref();
 }
 
 ByteArray::Node::Node()
     : ptr(nullptr)
     , size(0)
-    , next(nullptr) {
+    , next(nullptr)
+    , block(nullptr) {
 }
 
 ByteArray::Node::~Node() {
-    if(ptr) {
-        delete[] ptr;
+    if(block) {
+        block->unref();
+    }
+}
+
+void ByteArray::Node::detach() {
+    if(block && block->readonly) {
+        throw std::logic_error("write to read-only ByteArray memory");
+    }
+    if(block && block->isShared()) {
+        Block* tmp = Block::Create(size);
+        memcpy(tmp->data, ptr, size);
+        block->unref();
+        block = tmp;
+        ptr = tmp->data;
     }
 }
 
@@ -35,7 +225,8 @@ ByteArray::ByteArray(size_t base_size)
     , m_size(0)
     , m_endian(FL_BIG_ENDIAN)
     , m_root(new Node(base_size))
-    , m_cur(m_root) {
+    , m_cur(m_root)
+    , m_curPos(0) {
 }
 
 ByteArray::~ByteArray() {
@@ -90,57 +281,176 @@ void ByteArray::writeFuint64(int64_t val) {
 }
 
 static uint32_t EncodeZigzag32(const int32_t& val) {
-    if(val < 0) {
-        return ((uint32_t)(val)) * 2 - 1;
-    } else {
-        return val * 2;
-    }
+    return ((uint32_t)val << 1) ^ (uint32_t)(val >> 31);
 }
 
-static uint32_t EncodeZigzag64(const int64_t& val) {
-    if(val < 0) {
-        return ((uint64_t)(val)) * 2 - 1;
-    } else {
-        return val * 2;
-    }
+static uint64_t EncodeZigzag64(const int64_t& val) {
+    return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
 }
 
 static int32_t DecodeZigzag32(const uint32_t& val) {
-    return (val >> 2) ^ -(val & 1);
+    return (int32_t)((val >> 1) ^ -(val & 1));
 }
 
-static int64_t DecodeZigzag64(const uint32_t& val) {
-    return (val >> 2) ^ -(val & 1);
+static int64_t DecodeZigzag64(const uint64_t& val) {
+    return (int64_t)((val >> 1) ^ -(val & 1));
 }
 
-void ByteArray::writeInt32  (int32_t val) {
-    writeUint32(EncodeZigzag32(val));
-}
+// 最长的varint(64位)占10字节
+static constexpr size_t s_varint_max = 10;
 
-void ByteArray::writeUint32 (int32_t val) {
-    uint8_t tmp[10];
-    uint8_t i = 0;
+static size_t EncodeVarint(uint64_t val, uint8_t* buf) {
+    size_t i = 0;
     while(val >= 0x80) {
-        tmp[i++] = (val & 0x7F | 0x80);
+        buf[i++] = (uint8_t)(val | 0x80);
         val >>= 7;
     }
-    tmp[i++] = val;
-    write(tmp, i);
+    buf[i++] = (uint8_t)val;
+    return i;
+}
+
+/**
+ * @brief 从连续内存中解码varint
+ *
+ * @param[in] p 至少有s_varint_max个可读字节
+ * @param[out] val 解码结果
+ *
+ * @return 消耗的字节数, 格式错误返回0
+ *
+ * @details 小端机器上一次读取8字节, 用停止位定位长度后把各字节的低7位拼接起来,
+ *          前8字节内结束的varint不需要逐字节分支
+ */
+static size_t DecodeVarint(const uint8_t* p, uint64_t& val) {
+#if FL_BYTE_ORDER == FL_LITTLE_ENDIAN
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    uint64_t stop = ~word & 0x8080808080808080ull;
+    if(FL_LICKLY(stop)) {
+        size_t len = (__builtin_ctzll(stop) >> 3) + 1;
+        uint64_t x = word & (len == 8 ? ~0ull : ((1ull << (len << 3)) - 1));
+#ifdef __BMI2__
+        val = _pext_u64(x, 0x7f7f7f7f7f7f7f7full);
+#else
+        x &= 0x7f7f7f7f7f7f7f7full;
+        x = ((x & 0x7f007f007f007f00ull) >> 1) | (x & 0x007f007f007f007full);
+        x = ((x & 0x3fff00003fff0000ull) >> 2) | (x & 0x00003fff00003fffull);
+        val = ((x & 0x0fffffff00000000ull) >> 4) | (x & 0x000000000fffffffull);
+#endif
+        return len;
+    }
+#endif
+    uint64_t result = 0;
+    for(size_t i = 0; i < s_varint_max; ++i) {
+        result |= (uint64_t)(p[i] & 0x7f) << (7 * i);
+        if(p[i] < 0x80) {
+            val = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+void ByteArray::writeInt32  (int32_t val) {
+    writeUint32(EncodeZigzag32(val));
+}
+
+void ByteArray::writeUint32 (uint32_t val) {
+    uint8_t tmp[s_varint_max];
+    write(tmp, EncodeVarint(val, tmp));
 }
 
 void ByteArray::writeInt64  (int64_t val) {
     writeUint64(EncodeZigzag64(val));
 }
 
-void ByteArray::writeUint64 (int64_t val) {
-    uint8_t tmp[5];
-    uint8_t i = 0;
-    while(val >= 0x80) {
-        tmp[i++] = (val & 0x7F | 0x80);
-        val >>= 7;
+void ByteArray::writeUint64 (uint64_t val) {
+    uint8_t tmp[s_varint_max];
+    write(tmp, EncodeVarint(val, tmp));
+}
+
+// 批量写入时先编码到栈上的缓冲区, 攒满后一次写入
+#define xx(type, encode) \
+    uint8_t tmp[s_varint_max * 32]; \
+    size_t len = 0; \
+    for(size_t i = 0; i < size; ++i) { \
+        if(len > sizeof(tmp) - s_varint_max) { \
+            write(tmp, len); \
+            len = 0; \
+        } \
+        len += EncodeVarint(encode(vals[i]), tmp + len); \
+    } \
+    write(tmp, len);
+
+void ByteArray::writeInt32s (const int32_t* vals, size_t size) {
+    xx(int32_t, EncodeZigzag32)
+}
+
+void ByteArray::writeUint32s(const uint32_t* vals, size_t size) {
+    xx(uint32_t, )
+}
+
+void ByteArray::writeInt64s (const int64_t* vals, size_t size) {
+    xx(int64_t, EncodeZigzag64)
+}
+
+void ByteArray::writeUint64s(const uint64_t* vals, size_t size) {
+    xx(uint64_t, )
+}
+#undef xx
+
+// 逐个元素交换字节序, dst可以与src相同; 连续的定长循环可以被编译器向量化
+template<class T>
+static void ByteswapArray(char* dst, const char* src, size_t size) {
+    for(size_t i = 0; i < size; ++i) {
+        T v;
+        memcpy(&v, src + i * sizeof(T), sizeof(T));
+        v = byteswap(v);
+        memcpy(dst + i * sizeof(T), &v, sizeof(T));
+    }
+}
+
+static void ByteswapArray(char* dst, const char* src, size_t size, size_t width) {
+    switch(width) {
+        case 2:
+            ByteswapArray<uint16_t>(dst, src, size);
+            break;
+        case 4:
+            ByteswapArray<uint32_t>(dst, src, size);
+            break;
+        case 8:
+            ByteswapArray<uint64_t>(dst, src, size);
+            break;
+        default:
+            if(dst != src) {
+                memcpy(dst, src, size * width);
+            }
+            break;
+    }
+}
+
+void ByteArray::writeSwapped(const void* vals, size_t size, size_t width) {
+    if(width == 1 || m_endian == FL_BYTE_ORDER) {
+        write(vals, size * width);
+        return;
+    }
+    addCapacity(size * width);
+    char tmp[4096];
+    size_t count = sizeof(tmp) / width;
+    const char* src = (const char*)vals;
+    while(size > 0) {
+        size_t n = size < count ? size : count;
+        ByteswapArray(tmp, src, n, width);
+        write(tmp, n * width);
+        src += n * width;
+        size -= n;
+    }
+}
+
+void ByteArray::readSwapped(void* vals, size_t size, size_t width) {
+    read(vals, size * width);
+    if(width != 1 && m_endian != FL_BYTE_ORDER) {
+        ByteswapArray((char*)vals, (const char*)vals, size, width);
     }
-    tmp[i++] = val;
-    write(tmp, i);
 }
 
 void ByteArray::writeFloat  (float val) {
@@ -172,7 +482,8 @@ void ByteArray::writeStringF64 (const std::string& val) {
 }
 
 void ByteArray::ByteArray::writeStringVint(const std::string& val) {
-    xx(64, val)
+    writeUint64(val.size());
+    write(val.c_str(), val.size());
 }
 
 #undef xx
@@ -228,42 +539,75 @@ uint64_t ByteArray::ByteArray::readFuint64() {
 
 #undef xx
 
-int32_t ByteArray::readInt32   (const int32_t& val) {
-    return DecodeZigzag32(readFint32());
-}
-
-uint32_t ByteArray::readUint32 (const int32_t& val) {
-    uint32_t result = 0;
-    for(int i = 0 ; i < 32 ; i += 7) {
+uint64_t ByteArray::readVarint() {
+    uint64_t val = 0;
+    if(m_cur) {
+        size_t npos = m_position - m_curPos;
+        size_t avail = m_cur->size - npos;
+        if(avail > getReadSize()) {
+            avail = getReadSize();
+        }
+        if(avail >= s_varint_max) {
+            size_t len = DecodeVarint((const uint8_t*)m_cur->ptr + npos, val);
+            if(FL_LICKLY(len)) {
+                m_position += len;
+                if(len == m_cur->size - npos) {
+                    m_curPos += m_cur->size;
+                    m_cur = m_cur->next;
+                }
+                return val;
+            }
+        }
+    }
+    // 跨节点或剩余不足s_varint_max字节时逐字节解码
+    for(int i = 0 ; i < 64 ; i += 7) {
         uint8_t b = readFuint8();
+        val |= ((uint64_t)(b & 0x7F)) << i;
         if(b < 0x80) {
-            result |= ((uint32_t)b) << i;
             break;
-        } else {
-            result |= (((uint32_t)(b & 0x7F)) << i);
         }
     }
-    return result;
+    return val;
 }
 
-int64_t ByteArray::readInt64   (const int64_t& val) {
-    return DecodeZigzag64(readFint64());
+int32_t ByteArray::readInt32   () {
+    return DecodeZigzag32((uint32_t)readVarint());
 }
 
-uint64_t ByteArray::readUint64 (const int64_t& val) {
-    uint64_t result = 0;
-    for(int i = 0 ; i < 64 ; i += 7) {
-        uint8_t b = readFuint8();
-        if(b < 0x80) {
-            result |= ((uint64_t)b) << i;
-            break;
-        } else {
-            result |= (((uint64_t)(b & 0x7F)) << i);
-        }
+uint32_t ByteArray::readUint32 () {
+    return (uint32_t)readVarint();
+}
+
+int64_t ByteArray::readInt64   () {
+    return DecodeZigzag64(readVarint());
+}
+
+uint64_t ByteArray::readUint64 () {
+    return readVarint();
+}
+
+#define xx(type, decode) \
+    for(size_t i = 0; i < size; ++i) { \
+        vals[i] = (type)decode(readVarint()); \
     }
-    return result;
+
+void ByteArray::readInt32s  (int32_t* vals, size_t size) {
+    xx(int32_t, DecodeZigzag32)
+}
+
+void ByteArray::readUint32s (uint32_t* vals, size_t size) {
+    xx(uint32_t, )
+}
+
+void ByteArray::readInt64s  (int64_t* vals, size_t size) {
+    xx(int64_t, DecodeZigzag64)
 }
 
+void ByteArray::readUint64s (uint64_t* vals, size_t size) {
+    xx(uint64_t, )
+}
+#undef xx
+
 float ByteArray::readFloat   () {
     uint32_t v = readFuint32();
     float val;
@@ -273,7 +617,7 @@ float ByteArray::readFloat   () {
 }
 
 double ByteArray::readDouble () {
-    uint64_t v = readFuint32();
+    uint64_t v = readFuint64();
     double val;
     memcpy(&val, &v, sizeof(v));
 
@@ -305,7 +649,7 @@ std::string ByteArray::readStringF64 () {
 }
 
 std::string ByteArray::ByteArray::readStringVint() {
-    uint64_t len = readFuint64();
+    uint64_t len = readUint64();
     std::string buf;
     buf.resize(len);
     read(&buf[0], len);
@@ -314,15 +658,24 @@ std::string ByteArray::ByteArray::readStringVint() {
 
 void ByteArray::clear() {
     m_position = m_size = 0;
-    m_capacity = m_base_size;
-    Node* tmp = m_root->next;
+    Node* tmp = m_root ? m_root->next : nullptr;
     while(tmp) {
         m_cur = tmp;
         tmp = tmp->next;
-        delete tmp;
+        delete m_cur;
+    }
+    if(m_root && (m_root->size != m_base_size || !m_root->block
+                || m_root->block->isShared() || m_root->block->readonly)) {
+        delete m_root;
+        m_root = nullptr;
+    }
+    if(!m_root) {
+        m_root = new Node(m_base_size);
     }
-    m_cur = m_root;
     m_root->next = nullptr;
+    m_capacity = m_root->size;
+    m_cur = m_root;
+    m_curPos = 0;
 }
 
 void ByteArray::write(const void* buf, size_t size) {
@@ -331,26 +684,20 @@ void ByteArray::write(const void* buf, size_t size) {
     }
     addCapacity(size);
 
-    size_t npos = m_position % m_base_size;
-    size_t ncap = m_cur->size - npos;
     size_t bpos = 0;
-
     while(size > 0) {
-        if(ncap >= size) {
-            memcpy(m_cur->ptr + npos, (const char*)buf + bpos, size);
-            if(m_cur->size == (npos + size)) {
-                m_cur = m_cur->next;
-            }
-            m_position += size;
-            bpos += size;
-            size = 0;
-        } else {
-            memcpy(m_cur->ptr + npos, (const char*)buf + bpos, ncap);
-            m_position += ncap;
-            bpos += ncap;
-            size -= ncap;
+        size_t npos = m_position - m_curPos;
+        size_t ncap = m_cur->size - npos;
+        size_t len = ncap < size ? ncap : size;
+
+        m_cur->detach();
+        memcpy(m_cur->ptr + npos, (const char*)buf + bpos, len);
+        m_position += len;
+        bpos += len;
+        size -= len;
+        if(len == ncap) {
+            m_curPos += m_cur->size;
             m_cur = m_cur->next;
-            npos = 0;
         }
     }
 
@@ -364,57 +711,41 @@ void ByteArray::read (void* buf, size_t size) {
         throw std::out_of_range("not enough len");
     }
 
-    size_t npos = m_position % m_base_size;
-    size_t ncap = m_cur->size - npos;
     size_t bpos = 0;
     while(size > 0) {
-        if(ncap >= size) {
-            memcpy((char*)buf + bpos, (char*)m_cur->ptr + npos, size);
-            if(m_cur->size == npos + size) {
-                m_cur = m_cur->next;
-            }
-            m_position += size;
-            bpos += size;
-            size = 0;
-        } else {
-            memcpy((char*)buf + bpos, m_cur->ptr + npos, ncap);
-            m_position += ncap;
-            bpos += ncap;
-            size -= ncap;
+        size_t npos = m_position - m_curPos;
+        size_t ncap = m_cur->size - npos;
+        size_t len = ncap < size ? ncap : size;
+
+        memcpy((char*)buf + bpos, m_cur->ptr + npos, len);
+        m_position += len;
+        bpos += len;
+        size -= len;
+        if(len == ncap) {
+            m_curPos += m_cur->size;
             m_cur = m_cur->next;
-            ncap = m_cur->size;
-            npos = 0;
         }
     }
 }
 
 void ByteArray::read (void* buf, size_t size, size_t position) const {
-    if(size > getReadSize()) {
+    if(position > m_size || size > m_size - position) {
         throw std::out_of_range("not enough len");
     }
 
-    size_t npos = m_position % m_base_size;
-    size_t ncap = m_cur->size - npos;
+    size_t npos = 0;
+    Node* cur = locate(position, npos);
+    npos = position - npos;
     size_t bpos = 0;
-    Node* cur = m_cur;
     while(size > 0) {
-        if(ncap >= size) {
-            memcpy((char*)buf + bpos, (char*)m_cur->ptr + npos, size);
-            if(cur->size == npos + size) {
-                cur = cur->next;
-            }
-            position += size;
-            bpos += size;
-            size = 0;
-        } else {
-            memcpy((char*)buf + bpos, m_cur->ptr + npos, ncap);
-            position += ncap;
-            bpos += ncap;
-            size -= ncap;
-            cur = cur->next;
-            ncap = cur->size;
-            npos = 0;
-        }
+        size_t ncap = cur->size - npos;
+        size_t len = ncap < size ? ncap : size;
+
+        memcpy((char*)buf + bpos, cur->ptr + npos, len);
+        bpos += len;
+        size -= len;
+        cur = cur->next;
+        npos = 0;
     }
 }
 
@@ -428,37 +759,45 @@ void ByteArray::setPosition(size_t pos) {
 		m_size = m_position;
 	}
 
-    m_cur = m_root;
-    while(pos >= m_cur->size) {
-        pos -= m_cur->size;
-        m_cur = m_cur->next;
-    }
-    if(pos == m_cur->size) {
-        m_cur = m_cur->next;
-    }
+    relocate();
 }
 
 bool ByteArray::writeToFile (const std::string& name) const {
-    std::fstream ofs;
-    ofs.open(name, std::ios::trunc | std::ios::binary);
-    if(!ofs) {
+    int fd = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0) {
         FL_LOG_ERROR(FL_SYS_LOG()) << "writeToFile name = " << name
                                    << " error , erorno = " << errno << " errstr = " << strerror(errno);
         return false;
     }
-    int64_t read_size = getReadSize();
-    int64_t pos = m_position;
-    Node* cur = m_cur;
-    while(read_size > 0) {
-        int diff = pos % m_base_size;
-        int64_t len = (read_size > (int64_t)m_base_size ? m_base_size : read_size - diff);
+    ON_SCOPE_EXIT {
+        close(fd);
+    };
 
-        ofs.write(cur->ptr + diff, len);
-        cur = cur->next;
-        pos += len;
-        read_size -= len;
+    std::vector<iovec> buffers;
+    getReadBuffers(buffers);
+    size_t idx = 0;
+    while(idx < buffers.size()) {
+        int cnt = buffers.size() - idx < IOV_MAX ? buffers.size() - idx : IOV_MAX;
+        ssize_t rt = writev(fd, &buffers[idx], cnt);
+        if(rt < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            FL_LOG_ERROR(FL_SYS_LOG()) << "writeToFile name = " << name
+                                       << " writev error , erorno = " << errno << " errstr = " << strerror(errno);
+            return false;
+        }
+        // 跳过已写完的iovec, 部分写入的调整起始位置
+        size_t n = rt;
+        while(idx < buffers.size() && n >= buffers[idx].iov_len) {
+            n -= buffers[idx].iov_len;
+            ++idx;
+        }
+        if(n > 0) {
+            buffers[idx].iov_base = (char*)buffers[idx].iov_base + n;
+            buffers[idx].iov_len -= n;
+        }
     }
-    ofs.close();
     return true;
 }
 
@@ -484,6 +823,57 @@ bool ByteArray::readFromFile(const std::string& name) {
     return true;
 }
 
+static void UnmapBlock(ByteArray::Block* block) {
+    munmap(block->data, block->size);
+    delete block;
+}
+
+bool ByteArray::mmapFromFile(const std::string& name) {
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        FL_LOG_ERROR(FL_SYS_LOG()) << "mmapFromFile name = " << name
+                                   << " error , erorno = " << errno << " errstr = " << strerror(errno);
+        return false;
+    }
+    ON_SCOPE_EXIT {
+        close(fd);
+    };
+
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        FL_LOG_ERROR(FL_SYS_LOG()) << "mmapFromFile name = " << name
+                                   << " fstat error , erorno = " << errno << " errstr = " << strerror(errno);
+        return false;
+    }
+    clear();
+    if(st.st_size == 0) {
+        return true;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED) {
+        FL_LOG_ERROR(FL_SYS_LOG()) << "mmapFromFile name = " << name
+                                   << " mmap error , erorno = " << errno << " errstr = " << strerror(errno);
+        return false;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    Block* block = new Block;
+    block->data = (char*)data;
+    block->size = st.st_size;
+    block->count.store(0, std::memory_order_relaxed);
+    block->release = &UnmapBlock;
+    block->readonly = true;
+
+    // 映射作为唯一的节点, 替换clear()留下的空节点
+    delete m_root;
+    m_root = new Node(block, block->data, block->size);
+    m_capacity = m_size = block->size;
+    m_position = 0;
+    relocate();
+    return true;
+}
+
 bool ByteArray::isLittleEdian() const {
     return m_endian == FL_LITTLE_ENDIAN;
 }
@@ -500,32 +890,180 @@ void ByteArray::addCapacity(size_t size) {
     if(size == 0) {
         return;
     }
-    int old_cap = getCapacity();
-    if(old_cap > size) {
+    size_t old_cap = getCapacity();
+    if(old_cap >= size) {
         return;
     }
 
     size = size - old_cap;
     size_t count = (size / m_base_size) + ((size % m_base_size) ? 1 : 0);
-    Node* tmp = m_root;
-    while(tmp->next) {
+    Node* tmp = m_cur ? m_cur : m_root;
+    while(tmp && tmp->next) {
         tmp = tmp->next;
     }
 
     Node* first = nullptr;
     for(size_t i = 0 ; i < count; ++i) {
-        tmp->next = new Node(m_base_size);
+        Node* node = new Node(m_base_size);
         if(first == nullptr) {
-            first = tmp->next;
+            first = node;
         }
-        tmp = tmp->next;
-        m_capacity += m_base_size;
+        if(tmp) {
+            tmp->next = node;
+        } else {
+            m_root = node;
+        }
+        tmp = node;
     }
 
     if(old_cap == 0) {
         m_cur = first;
+        m_curPos = m_capacity;
+    }
+    m_capacity += count * m_base_size;
+}
+
+ByteArray::Node* ByteArray::locate(size_t pos, size_t& node_pos) const {
+    Node* cur = m_root;
+    node_pos = 0;
+    if(m_cur && pos >= m_curPos) {
+        cur = m_cur;
+        node_pos = m_curPos;
+    }
+    while(cur && pos >= node_pos + cur->size) {
+        node_pos += cur->size;
+        cur = cur->next;
+    }
+    return cur;
+}
+
+void ByteArray::relocate() {
+    size_t node_pos = 0;
+    m_cur = locate(m_position, node_pos);
+    m_curPos = m_cur ? node_pos : m_capacity;
+}
+
+ByteArray::Node* ByteArray::split(size_t pos) {
+    if(pos == 0) {
+        return nullptr;
+    }
+    size_t node_pos = 0;
+    Node* cur = m_root;
+    Node* prev = nullptr;
+    while(cur && pos >= node_pos + cur->size) {
+        node_pos += cur->size;
+        prev = cur;
+        cur = cur->next;
+    }
+    if(!cur || pos == node_pos) {
+        return prev;
+    }
+    size_t npos = pos - node_pos;
+    Node* tail = new Node(cur->block, cur->ptr + npos, cur->size - npos);
+    tail->next = cur->next;
+    cur->size = npos;
+    cur->next = tail;
+    return cur;
+}
+
+void ByteArray::trimCapacity() {
+    Node* last = split(m_size);
+    Node* tmp = last ? last->next : m_root;
+    if(last) {
+        last->next = nullptr;
+    } else {
+        m_root = nullptr;
+    }
+    while(tmp) {
+        Node* next = tmp->next;
+        delete tmp;
+        tmp = next;
+    }
+    m_capacity = m_size;
+    m_cur = nullptr;
+    relocate();
+}
+
+ByteArray::Node* ByteArray::makeViews(const ByteArray& ba, size_t pos, size_t len, Node*& tail) {
+    Node* head = nullptr;
+    tail = nullptr;
+    size_t npos = 0;
+    Node* cur = ba.locate(pos, npos);
+    npos = pos - npos;
+    while(len > 0) {
+        size_t n = cur->size - npos < len ? cur->size - npos : len;
+        Node* node = new Node(cur->block, cur->ptr + npos, n);
+        if(tail) {
+            tail->next = node;
+        } else {
+            head = node;
+        }
+        tail = node;
+        len -= n;
+        cur = cur->next;
+        npos = 0;
+    }
+    return head;
+}
+
+ByteArray::ptr ByteArray::slice(size_t pos, size_t len) const {
+    if(pos > m_size || len > m_size - pos) {
+        throw std::out_of_range("slice out of range");
+    }
+    ByteArray::ptr ba(new ByteArray(m_base_size));
+    ba->m_endian = m_endian;
+    ba->trimCapacity();
+
+    Node* tail = nullptr;
+    ba->m_root = makeViews(*this, pos, len, tail);
+    ba->m_capacity = ba->m_size = len;
+    ba->relocate();
+    return ba;
+}
+
+void ByteArray::append(const ByteArray& ba) {
+    size_t len = ba.getReadSize();
+    if(len == 0) {
+        return;
     }
+    Node* tail = nullptr;
+    Node* head = makeViews(ba, ba.m_position, len, tail);
 
+    trimCapacity();
+    Node* last = m_root;
+    while(last && last->next) {
+        last = last->next;
+    }
+    if(last) {
+        last->next = head;
+    } else {
+        m_root = head;
+    }
+    m_capacity += len;
+    m_size += len;
+    relocate();
+}
+
+void ByteArray::prepend(const ByteArray& ba) {
+    size_t len = ba.getReadSize();
+    if(len == 0) {
+        return;
+    }
+    Node* tail = nullptr;
+    Node* head = makeViews(ba, ba.m_position, len, tail);
+
+    Node* prev = split(m_position);
+    if(prev) {
+        tail->next = prev->next;
+        prev->next = head;
+    } else {
+        tail->next = m_root;
+        m_root = head;
+    }
+    m_capacity += len;
+    m_size += len;
+    m_cur = head;
+    m_curPos = m_position;
 }
 
 std::string ByteArray::toString() const {
@@ -538,84 +1076,118 @@ std::string ByteArray::toString() const {
     return str;
 }
 
-std::string ByteArray::toHexString() const {
-    std::string str = toString();
-    std::stringstream ss;
-
-    for(size_t i = 0 ; i < str.size() ; ++i) {
-        if(i > 0 && i % 32 == 0) {
-            ss << std::endl;
-        }
-        ss << std::setw(2) << std::setfill('0') << std::hex
-           << (int)(uint8_t)str[i] << " ";
+static const char s_hex_digits[] = "0123456789abcdef";
+
+// 编码成连续的小写十六进制, out至少2 * len字节
+static void HexEncode(const uint8_t* in, size_t len, char* out) {
+#ifdef __SSE2__
+    // 每次16字节: 拆出高低4位, 0-9加'0', 10-15再加('a' - '0' - 10), 然后交错写出
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i alpha = _mm_set1_epi8('a' - '0' - 10);
+    while(len >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)in);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        __m128i lo = _mm_and_si128(v, mask);
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), alpha));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), alpha));
+        _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_unpackhi_epi8(hi, lo));
+        in += 16;
+        out += 32;
+        len -= 16;
+    }
+#endif
+    for(size_t i = 0; i < len; ++i) {
+        out[i * 2] = s_hex_digits[in[i] >> 4];
+        out[i * 2 + 1] = s_hex_digits[in[i] & 0x0f];
     }
-    return ss.str();
 }
 
-uint64_t ByteArray::getReadBuffers(std::vector<iovec>& buffers, uint64_t len) const {
+std::string ByteArray::toHexString() const {
+    // 每字节"xx ", 每32字节换行
+    std::vector<iovec> iovs;
+    size_t len = getReadBuffers(iovs);
+    std::string str;
     if(len == 0) {
-        return 0;
+        return str;
+    }
+    str.resize(len * 3 + (len - 1) / 32);
+    char* out = &str[0];
+    size_t i = 0;
+    for(auto& iov : iovs) {
+        const uint8_t* p = (const uint8_t*)iov.iov_base;
+        for(size_t j = 0; j < iov.iov_len; ++j, ++i) {
+            if(i > 0 && i % 32 == 0) {
+                *out++ = '\n';
+            }
+            *out++ = s_hex_digits[p[j] >> 4];
+            *out++ = s_hex_digits[p[j] & 0x0f];
+            *out++ = ' ';
+        }
     }
-    len = len > getReadSize() ? getReadSize() : len;
+    return str;
+}
 
-    uint64_t size = len;
+std::string ByteArray::toHex() const {
+    std::vector<iovec> iovs;
+    size_t len = getReadBuffers(iovs);
+    std::string str;
+    str.resize(len * 2);
+    size_t pos = 0;
+    for(auto& iov : iovs) {
+        HexEncode((const uint8_t*)iov.iov_base, iov.iov_len, &str[pos]);
+        pos += iov.iov_len * 2;
+    }
+    return str;
+}
 
-    size_t npos = m_position % m_base_size;
-    size_t ncap = m_cur->size - npos;
-    struct iovec iov;
+uint32_t ByteArray::crc32c(uint32_t crc) const {
+    std::vector<iovec> iovs;
+    getReadBuffers(iovs);
+    for(auto& iov : iovs) {
+        crc = Crc32c(crc, iov.iov_base, iov.iov_len);
+    }
+    return crc;
+}
 
-    Node* cur = m_cur;
-    while(len > 0) {
-        if(ncap >= len) {
-            iov.iov_base = cur->ptr + npos;
-            iov.iov_len = len;
-            len = 0;
-        } else {
-            iov.iov_base = cur->ptr + npos;
-            iov.iov_len = ncap;
-            len -= ncap;
-            cur = cur->next;
-            ncap = cur->size;
-            npos = 0;
-        }
-        buffers.push_back(iov);
+uint64_t ByteArray::xxhash64(uint64_t seed) const {
+    std::vector<iovec> iovs;
+    getReadBuffers(iovs);
+    XXHash64 hash(seed);
+    for(auto& iov : iovs) {
+        hash.update(iov.iov_base, iov.iov_len);
     }
-    return size;
+    return hash.digest();
+}
+
+uint64_t ByteArray::getReadBuffers(std::vector<iovec>& buffers, uint64_t len) const {
+    return getReadBuffers(buffers, len, m_position);
 }
 
 uint64_t ByteArray::getReadBuffers(std::vector<iovec>& buffers, uint64_t len, uint64_t position) const {
-    len = len > getReadSize() ? getReadSize() : len;
+    if(position > m_size) {
+        return 0;
+    }
+    len = len > m_size - position ? m_size - position : len;
     if(len == 0) {
         return 0;
     }
 
     uint64_t size = len;
-
-    size_t npos = position % m_base_size;
-
-    size_t count = position / m_base_size;
-    Node* cur = m_root;
-    while(count > 0) {
-        cur = cur->next;
-        --count;
-    }
-
-    size_t ncap = cur->size - npos;
+    size_t npos = 0;
+    Node* cur = locate(position, npos);
+    npos = position - npos;
     struct iovec iov;
 
     while(len > 0) {
-        if(ncap >= len) {
-            iov.iov_base = cur->ptr + npos;
-            iov.iov_len = len;
-            len = 0;
-        } else {
-            iov.iov_base = cur->ptr + npos;
-            iov.iov_len = ncap;
-            len -= ncap;
-            cur = cur->next;
-            ncap = cur->size;
-            npos = 0;
-        }
+        size_t ncap = cur->size - npos;
+        iov.iov_base = cur->ptr + npos;
+        iov.iov_len = ncap < len ? ncap : len;
+        len -= iov.iov_len;
+        cur = cur->next;
+        npos = 0;
         buffers.push_back(iov);
     }
     return size;
@@ -627,24 +1199,17 @@ uint64_t ByteArray::getWriteBuffers(std::vector<iovec>& buffers, uint64_t len) {
     }
     addCapacity(len);
     uint64_t size = len;
-    size_t npos = m_position % m_base_size;
-    size_t ncap = m_cur->size - npos;
+    size_t npos = m_position - m_curPos;
     struct iovec iov;
     Node* cur = m_cur;
     while(len > 0) {
-        if(ncap >= len) {
-            iov.iov_base = cur->ptr + npos;
-            iov.iov_len = len;
-            len = 0;
-        } else {
-            iov.iov_base = cur->ptr + npos;
-            iov.iov_len = ncap;
-
-            len -= ncap;
-            cur = cur->next;
-            ncap = cur->size;
-            npos = 0;
-        }
+        cur->detach();
+        size_t ncap = cur->size - npos;
+        iov.iov_base = cur->ptr + npos;
+        iov.iov_len = ncap < len ? ncap : len;
+        len -= iov.iov_len;
+        cur = cur->next;
+        npos = 0;
         buffers.push_back(iov);
     }
     return size;
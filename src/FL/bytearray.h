@@ -1,8 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <stdint.h>
+#include <type_traits>
 #include <vector>
 #include <sys/uio.h>
 
@@ -12,19 +14,61 @@ class ByteArray {
   public:
     typedef std::shared_ptr<ByteArray> ptr;
 
+    // 引用计数的内存块,slice/append/prepend后多个Node共享同一块内存
+    struct Block {
+        static Block* Create(size_t size);
+
+        void ref() {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+        void unref() {
+            if(count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                release(this);
+            }
+        }
+        bool isShared() const {
+            return count.load(std::memory_order_acquire) > 1;
+        }
+
+        char* data;
+        size_t size;
+        std::atomic<uint32_t> count;
+        void (*release)(Block* block);
+        bool readonly;              // 只读内存(如文件映射), 写入时抛出异常
+    };
+
+    // 指向Block中一段内存的节点,节点大小可以不同
     struct Node {
         Node(size_t size);
+        Node(Block* block, char* ptr, size_t size);
         Node();
         ~Node();
 
+        // 内存块被共享时复制一份,保证写入不影响其他ByteArray; 只读内存块抛出std::logic_error
+        void detach();
+
         char* ptr;
         size_t size;
         Node* next;
+        Block* block;
+    };
+
+    // 内存块池统计, hits/misses为当前线程, footprint/peak为全局
+    struct PoolStats {
+        uint64_t hits;          // 从池中取到块的次数
+        uint64_t misses;        // 向系统申请新块的次数
+        uint64_t footprint;     // 池化块当前占用的字节数(含缓存)
+        uint64_t peak;          // footprint的峰值
     };
 
     ByteArray(size_t base_size = 4096);
     ~ByteArray();
 
+    // 节点内存默认从线程私有的池中分配(不超过64KB的块)
+    static PoolStats GetPoolStats();
+    static void SetPoolEnabled(bool v);
+    static bool IsPoolEnabled();
+
     // write
     void writeFint8	    (int8_t  val);
     void writeFuint8    (int8_t  val);
@@ -35,10 +79,16 @@ class ByteArray {
     void writeFint64    (int64_t val);
     void writeFuint64   (int64_t val);
 
-    void writeInt32     (int32_t val);
-    void writeUint32    (int32_t val);
-    void writeInt64     (int64_t val);
-    void writeUint64    (int64_t val);
+    void writeInt32     (int32_t  val);
+    void writeUint32    (uint32_t val);
+    void writeInt64     (int64_t  val);
+    void writeUint64    (uint64_t val);
+
+    // 批量写入varint
+    void writeInt32s    (const int32_t*  vals, size_t size);
+    void writeUint32s   (const uint32_t* vals, size_t size);
+    void writeInt64s    (const int64_t*  vals, size_t size);
+    void writeUint64s   (const uint64_t* vals, size_t size);
 
     void writeFloat		(float   val);
     void writeDouble    (double  val);
@@ -50,6 +100,13 @@ class ByteArray {
 
     void writeStringWithoutLength(const std::string& val);
 
+    // 批量写入定长数值(整数/浮点), 字节序与本机不同时才做字节交换
+    template<class T>
+    void writeFixedArray(const T* vals, size_t size) {
+        static_assert(std::is_arithmetic<T>::value, "writeFixedArray only supports arithmetic types");
+        writeSwapped(vals, size, sizeof(T));
+    }
+
     // read
     int8_t   readFint8  ();
     uint8_t  readFuint8 ();
@@ -60,10 +117,23 @@ class ByteArray {
     int64_t  readFint64 ();
     uint64_t readFuint64();
 
-    int32_t  readInt32  (const int32_t& val);
-    uint32_t readUint32 (const int32_t& val);
-    int64_t  readInt64  (const int64_t& val);
-    uint64_t readUint64 (const int64_t& val);
+    int32_t  readInt32  ();
+    uint32_t readUint32 ();
+    int64_t  readInt64  ();
+    uint64_t readUint64 ();
+
+    // 批量读取varint
+    void readInt32s     (int32_t*  vals, size_t size);
+    void readUint32s    (uint32_t* vals, size_t size);
+    void readInt64s     (int64_t*  vals, size_t size);
+    void readUint64s    (uint64_t* vals, size_t size);
+
+    // 批量读取定长数值, 与writeFixedArray对应
+    template<class T>
+    void readFixedArray(T* vals, size_t size) {
+        static_assert(std::is_arithmetic<T>::value, "readFixedArray only supports arithmetic types");
+        readSwapped(vals, size, sizeof(T));
+    }
 
     float	 readFloat	();
     double	 readDouble	();
@@ -86,6 +156,8 @@ class ByteArray {
 
     bool writeToFile (const std::string& name) const;
     bool readFromFile(const std::string& name);
+    // 以只读方式映射整个文件, 不复制数据; 映射在所有引用它的ByteArray释放后解除
+    bool mmapFromFile(const std::string& name);
 
     size_t getBaseSize() const {
         return m_base_size;
@@ -99,18 +171,49 @@ class ByteArray {
 
     std::string toString()	  const;
     std::string toHexString() const;
+    // 可读数据的连续小写十六进制(无分隔符)
+    std::string toHex() const;
+
+    // 直接在节点上计算可读数据的校验值, 不合并内存; crc/seed用于分段累计
+    uint32_t crc32c(uint32_t crc = 0) const;
+    uint64_t xxhash64(uint64_t seed = 0) const;
+
+    // 零拷贝:返回[pos, pos + len)的视图,与当前对象共享内存,写入时复制
+    ByteArray::ptr slice(size_t pos, size_t len) const;
+    // 零拷贝:将ba的可读数据拼接到末尾,丢弃当前未使用的容量
+    void append(const ByteArray& ba);
+    // 零拷贝:将ba的可读数据插入到当前读写位置,下一次读取从插入的数据开始
+    void prepend(const ByteArray& ba);
 
     uint64_t getReadBuffers (std::vector<iovec>& buffers, uint64_t len = ~0ull) const;
     uint64_t getReadBuffers (std::vector<iovec>& buffers, uint64_t len, uint64_t position) const;
     uint64_t getWriteBuffers(std::vector<iovec>& buffers, uint64_t len);
-  private:
+
     bool isLittleEdian() const;
     void setIsLittleEndian(bool val);
 
+    // 保证从当前位置起至少有size字节可写, 提前一次性分配节点
     void addCapacity(size_t size);
+  private:
+    // 读取一个varint, 当前节点有足够的连续数据时走快速路径
+    uint64_t readVarint();
+    // 按width字节一个元素批量写入/读取, 需要时交换字节序
+    void writeSwapped(const void* vals, size_t size, size_t width);
+    void readSwapped (void* vals, size_t size, size_t width);
     size_t getCapacity() const {
         return m_capacity - m_position;
     }
+
+    // 查找pos所在的节点, node_pos返回节点起始位置
+    Node* locate(size_t pos, size_t& node_pos) const;
+    // 在pos处切分节点,返回pos之前的节点(pos为0时返回nullptr)
+    Node* split(size_t pos);
+    // 丢弃m_size之后未使用的容量
+    void trimCapacity();
+    // 生成ba中[pos, pos + len)的视图节点链表
+    static Node* makeViews(const ByteArray& ba, size_t pos, size_t len, Node*& tail);
+    // 重新定位m_cur
+    void relocate();
   private:
     size_t m_base_size;
     size_t m_position;
@@ -119,6 +222,7 @@ class ByteArray {
     int8_t m_endian;
     Node*  m_root;
     Node*  m_cur;
+    size_t m_curPos;    // m_cur的起始位置
 };
 
 }
@@ -0,0 +1,181 @@
+#include "checksum.h"
+#include <endian.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#endif
+
+namespace FL {
+
+namespace {
+
+struct Crc32cTable {
+    uint32_t table[256];
+
+    Crc32cTable() {
+        for(uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for(int j = 0; j < 8; ++j) {
+                crc = (crc >> 1) ^ (0x82F63B78 & -(crc & 1));
+            }
+            table[i] = crc;
+        }
+    }
+};
+
+static const Crc32cTable s_crc32c_table;
+
+static uint32_t Crc32cSw(uint32_t crc, const uint8_t* p, size_t len) {
+    for(size_t i = 0; i < len; ++i) {
+        crc = s_crc32c_table.table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t Crc32cHw(uint32_t crc, const uint8_t* p, size_t len) {
+    uint64_t c = crc;
+    while(len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        c = _mm_crc32_u64(c, v);
+        p += 8;
+        len -= 8;
+    }
+    uint32_t c32 = (uint32_t)c;
+    while(len > 0) {
+        c32 = _mm_crc32_u8(c32, *p++);
+        --len;
+    }
+    return c32;
+}
+
+static const bool s_has_sse42 = __builtin_cpu_supports("sse4.2");
+#endif
+
+static constexpr uint64_t P1 = 11400714785074694791ull;
+static constexpr uint64_t P2 = 14029467366897019727ull;
+static constexpr uint64_t P3 = 1609587929392839161ull;
+static constexpr uint64_t P4 = 9650029242287828579ull;
+static constexpr uint64_t P5 = 2870177450012600261ull;
+
+static inline uint64_t Rotl(uint64_t v, int r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+static inline uint64_t Read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return le64toh(v);
+}
+
+static inline uint32_t Read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return le32toh(v);
+}
+
+static inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    acc = Rotl(acc, 31);
+    return acc * P1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+    acc ^= Round(0, val);
+    return acc * P1 + P4;
+}
+
+}
+
+uint32_t Crc32c(uint32_t crc, const void* data, size_t len) {
+#if defined(__x86_64__)
+    if(s_has_sse42) {
+        return ~Crc32cHw(~crc, (const uint8_t*)data, len);
+    }
+#endif
+    return ~Crc32cSw(~crc, (const uint8_t*)data, len);
+}
+
+XXHash64::XXHash64(uint64_t seed)
+    : m_seed(seed)
+    , m_total(0)
+    , m_bufSize(0) {
+    m_v[0] = seed + P1 + P2;
+    m_v[1] = seed + P2;
+    m_v[2] = seed;
+    m_v[3] = seed - P1;
+}
+
+void XXHash64::update(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    m_total += len;
+
+    if(m_bufSize + len < 32) {
+        memcpy(m_buf + m_bufSize, p, len);
+        m_bufSize += len;
+        return;
+    }
+    if(m_bufSize) {
+        size_t n = 32 - m_bufSize;
+        memcpy(m_buf + m_bufSize, p, n);
+        for(int i = 0; i < 4; ++i) {
+            m_v[i] = Round(m_v[i], Read64(m_buf + i * 8));
+        }
+        p += n;
+        len -= n;
+        m_bufSize = 0;
+    }
+    while(len >= 32) {
+        for(int i = 0; i < 4; ++i) {
+            m_v[i] = Round(m_v[i], Read64(p + i * 8));
+        }
+        p += 32;
+        len -= 32;
+    }
+    memcpy(m_buf, p, len);
+    m_bufSize = len;
+}
+
+uint64_t XXHash64::digest() const {
+    uint64_t h = 0;
+    if(m_total >= 32) {
+        h = Rotl(m_v[0], 1) + Rotl(m_v[1], 7) + Rotl(m_v[2], 12) + Rotl(m_v[3], 18);
+        for(int i = 0; i < 4; ++i) {
+            h = MergeRound(h, m_v[i]);
+        }
+    } else {
+        h = m_seed + P5;
+    }
+    h += m_total;
+
+    const uint8_t* p = m_buf;
+    size_t len = m_bufSize;
+    while(len >= 8) {
+        h ^= Round(0, Read64(p));
+        h = Rotl(h, 27) * P1 + P4;
+        p += 8;
+        len -= 8;
+    }
+    if(len >= 4) {
+        h ^= (uint64_t)Read32(p) * P1;
+        h = Rotl(h, 23) * P2 + P3;
+        p += 4;
+        len -= 4;
+    }
+    while(len > 0) {
+        h ^= (*p++) * P5;
+        h = Rotl(h, 11) * P1;
+        --len;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+}
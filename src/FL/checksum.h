@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace FL {
+
+/**
+ * @brief 计算CRC32C(Castagnoli), 支持SSE4.2的CPU上使用crc32指令
+ *
+ * @param[in] crc 上一段数据的结果, 第一段传0
+ * @param[in] data 数据
+ * @param[in] len 长度
+ *
+ * @return 累计的CRC32C
+ */
+uint32_t Crc32c(uint32_t crc, const void* data, size_t len);
+
+/**
+ * @brief 流式计算XXH64, 结果与xxHash官方实现一致
+ */
+class XXHash64 {
+  public:
+    XXHash64(uint64_t seed = 0);
+
+    void update(const void* data, size_t len);
+    uint64_t digest() const;
+  private:
+    uint64_t m_v[4];        // 4路累加器
+    uint64_t m_seed;
+    uint64_t m_total;       // 已输入的总长度
+    uint8_t  m_buf[32];     // 不足一个stripe的数据
+    uint32_t m_bufSize;
+};
+
+}
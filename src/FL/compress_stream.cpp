@@ -0,0 +1,369 @@
+#include "compress_stream.h"
+#include "logmanager.h"
+#include <limits.h>
+#include <string.h>
+#include <vector>
+#include <zlib.h>
+#ifdef FL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace FL {
+
+static auto syslog = FL_SYS_LOG();
+
+// 压缩数据攒到该大小后发送, 解压时每次从被包装的流读取的大小
+static constexpr size_t s_chunk_size = 64 * 1024;
+
+namespace {
+
+class ZlibCodec : public Codec {
+  public:
+    ZlibCodec(bool compress)
+        : m_compress(compress)
+        , m_inited(false) {
+        memset(&m_zstream, 0, sizeof(m_zstream));
+    }
+
+    ~ZlibCodec() {
+        if(!m_inited) {
+            return;
+        }
+        if(m_compress) {
+            deflateEnd(&m_zstream);
+        } else {
+            inflateEnd(&m_zstream);
+        }
+    }
+
+    bool init(int window_bits, int level) {
+        int rt = m_compress ? deflateInit2(&m_zstream, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY)
+                            : inflateInit2(&m_zstream, window_bits);
+        if(rt != Z_OK) {
+            FL_LOG_ERROR(syslog) << "zlib init error rt=" << rt << " window_bits=" << window_bits;
+            return false;
+        }
+        m_inited = true;
+        return true;
+    }
+
+    int process(const char*& in, size_t& in_len, char*& out, size_t& out_len, Flush flush) override {
+        uInt in_avail = in_len < UINT_MAX ? in_len : UINT_MAX;
+        uInt out_avail = out_len < UINT_MAX ? out_len : UINT_MAX;
+        m_zstream.next_in = (Bytef*)in;
+        m_zstream.avail_in = in_avail;
+        m_zstream.next_out = (Bytef*)out;
+        m_zstream.avail_out = out_avail;
+
+        int rt = 0;
+        if(m_compress) {
+            rt = deflate(&m_zstream, flush == NONE ? Z_NO_FLUSH : (flush == FLUSH ? Z_SYNC_FLUSH : Z_FINISH));
+        } else {
+            rt = inflate(&m_zstream, Z_NO_FLUSH);
+        }
+
+        in += in_avail - m_zstream.avail_in;
+        in_len -= in_avail - m_zstream.avail_in;
+        out += out_avail - m_zstream.avail_out;
+        out_len -= out_avail - m_zstream.avail_out;
+
+        if(rt == Z_STREAM_END) {
+            return 0;
+        }
+        if(rt != Z_OK && rt != Z_BUF_ERROR) {
+            FL_LOG_ERROR(syslog) << "zlib " << (m_compress ? "deflate" : "inflate")
+                                 << " error rt=" << rt << " msg=" << (m_zstream.msg ? m_zstream.msg : "");
+            return -1;
+        }
+        // 同步刷新时输出缓冲没有写满说明已全部输出
+        if(m_compress && flush == FLUSH && m_zstream.avail_out > 0) {
+            return 0;
+        }
+        return 1;
+    }
+  private:
+    z_stream m_zstream;
+    bool m_compress;
+    bool m_inited;
+};
+
+#ifdef FL_HAVE_ZSTD
+class ZstdCodec : public Codec {
+  public:
+    ZstdCodec(bool compress, int level)
+        : m_cctx(nullptr)
+        , m_dctx(nullptr) {
+        if(compress) {
+            m_cctx = ZSTD_createCCtx();
+            ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, level < 0 ? ZSTD_CLEVEL_DEFAULT : level);
+        } else {
+            m_dctx = ZSTD_createDCtx();
+        }
+    }
+
+    ~ZstdCodec() {
+        if(m_cctx) {
+            ZSTD_freeCCtx(m_cctx);
+        }
+        if(m_dctx) {
+            ZSTD_freeDCtx(m_dctx);
+        }
+    }
+
+    int process(const char*& in, size_t& in_len, char*& out, size_t& out_len, Flush flush) override {
+        ZSTD_inBuffer ib = {in, in_len, 0};
+        ZSTD_outBuffer ob = {out, out_len, 0};
+        size_t rt = 0;
+        if(m_cctx) {
+            rt = ZSTD_compressStream2(m_cctx, &ob, &ib, flush == NONE ? ZSTD_e_continue
+                                      : (flush == FLUSH ? ZSTD_e_flush : ZSTD_e_end));
+        } else {
+            rt = ZSTD_decompressStream(m_dctx, &ob, &ib);
+        }
+        if(ZSTD_isError(rt)) {
+            FL_LOG_ERROR(syslog) << "zstd error: " << ZSTD_getErrorName(rt);
+            return -1;
+        }
+        in += ib.pos;
+        in_len -= ib.pos;
+        out += ob.pos;
+        out_len -= ob.pos;
+        if(m_dctx || flush != NONE) {
+            return rt == 0 ? 0 : 1;
+        }
+        return 1;
+    }
+  private:
+    ZSTD_CCtx* m_cctx;
+    ZSTD_DCtx* m_dctx;
+};
+#endif
+
+/**
+ * @brief 把一段输入交给编码器, 输出直接写入out的节点
+ *
+ * @return 同Codec::process
+ */
+int Pump(Codec& codec, const char*& in, size_t& in_len, ByteArray& out, Codec::Flush flush) {
+    std::vector<iovec> iovs;
+    while(true) {
+        iovs.clear();
+        out.getWriteBuffers(iovs, out.getBaseSize());
+        char* ptr = (char*)iovs[0].iov_base;
+        size_t len = iovs[0].iov_len;
+        int rt = codec.process(in, in_len, ptr, len, flush);
+        out.setPosition(out.getPosition() + iovs[0].iov_len - len);
+        if(rt <= 0) {
+            return rt;
+        }
+        // 输入已消耗完且输出没有写满, 编码器内没有待输出的数据
+        if(flush == Codec::NONE && in_len == 0 && len > 0) {
+            return rt;
+        }
+    }
+}
+
+}
+
+Codec::ptr CompressStream::CreateCodec(Type type, Mode mode, int level) {
+    switch(type) {
+        case DEFLATE:
+        case ZLIB:
+        case GZIP: {
+                static const int s_window_bits[] = {-15, 15, 31};
+                std::shared_ptr<ZlibCodec> codec(new ZlibCodec(mode == COMPRESS));
+                if(!codec->init(s_window_bits[type], level < 0 ? Z_DEFAULT_COMPRESSION : level)) {
+                    return nullptr;
+                }
+                return codec;
+            }
+#ifdef FL_HAVE_ZSTD
+        case ZSTD:
+            return Codec::ptr(new ZstdCodec(mode == COMPRESS, level));
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+bool CompressStream::Compress(ByteArray& in, ByteArray& out, Type type, int level) {
+    Codec::ptr codec = CreateCodec(type, COMPRESS, level);
+    if(!codec) {
+        return false;
+    }
+    std::vector<iovec> iovs;
+    size_t len = in.getReadBuffers(iovs);
+    for(auto& iov : iovs) {
+        const char* ptr = (const char*)iov.iov_base;
+        size_t left = iov.iov_len;
+        if(Pump(*codec, ptr, left, out, Codec::NONE) < 0) {
+            return false;
+        }
+    }
+    const char* ptr = nullptr;
+    size_t left = 0;
+    if(Pump(*codec, ptr, left, out, Codec::FINISH) != 0) {
+        return false;
+    }
+    in.setPosition(in.getPosition() + len);
+    return true;
+}
+
+bool CompressStream::Decompress(ByteArray& in, ByteArray& out, Type type) {
+    Codec::ptr codec = CreateCodec(type, DECOMPRESS);
+    if(!codec) {
+        return false;
+    }
+    std::vector<iovec> iovs;
+    in.getReadBuffers(iovs);
+    size_t consumed = 0;
+    for(auto& iov : iovs) {
+        const char* ptr = (const char*)iov.iov_base;
+        size_t left = iov.iov_len;
+        int rt = Pump(*codec, ptr, left, out, Codec::NONE);
+        consumed += iov.iov_len - left;
+        if(rt < 0) {
+            return false;
+        }
+        if(rt == 0) {
+            in.setPosition(in.getPosition() + consumed);
+            return true;
+        }
+    }
+    FL_LOG_ERROR(syslog) << "decompress truncated input, consumed=" << consumed;
+    return false;
+}
+
+CompressStream::CompressStream(Stream::ptr stream, Type type, Mode mode, int level, bool owner)
+    : m_stream(stream)
+    , m_codec(CreateCodec(type, mode, level))
+    , m_mode(mode)
+    , m_owner(owner)
+    , m_finished(false)
+    , m_buf(new ByteArray) {
+}
+
+CompressStream::~CompressStream() {
+}
+
+int CompressStream::read(void* buffer, size_t length) {
+    if(m_mode != DECOMPRESS || !m_codec) {
+        return -1;
+    }
+    if(m_finished || length == 0) {
+        return 0;
+    }
+
+    std::vector<iovec> iovs;
+    while(true) {
+        if(m_buf->getReadSize() == 0) {
+            m_buf->clear();
+            int rt = m_stream->read(m_buf, s_chunk_size);
+            if(rt <= 0) {
+                return rt;
+            }
+            m_buf->setPosition(0);
+        }
+
+        iovs.clear();
+        m_buf->getReadBuffers(iovs, m_buf->getReadSize());
+        const char* in = (const char*)iovs[0].iov_base;
+        size_t in_len = iovs[0].iov_len;
+        char* out = (char*)buffer;
+        size_t out_len = length;
+        int rt = m_codec->process(in, in_len, out, out_len, Codec::NONE);
+        m_buf->setPosition(m_buf->getPosition() + iovs[0].iov_len - in_len);
+        if(rt < 0) {
+            return -1;
+        }
+        if(rt == 0) {
+            m_finished = true;
+        }
+        if(out_len < length || m_finished) {
+            return length - out_len;
+        }
+    }
+}
+
+int CompressStream::read(ByteArray::ptr byte_arr, size_t length) {
+    std::vector<iovec> iovs;
+    if(!byte_arr->getWriteBuffers(iovs, length)) {
+        return -1;
+    }
+    int rt = read(iovs[0].iov_base, iovs[0].iov_len);
+    if(rt > 0) {
+        byte_arr->setPosition(byte_arr->getPosition() + rt);
+    }
+    return rt;
+}
+
+int CompressStream::compress(const char* buf, size_t len, Codec::Flush flush) {
+    if(m_mode != COMPRESS || !m_codec || m_finished) {
+        return -1;
+    }
+    int rt = Pump(*m_codec, buf, len, *m_buf, flush);
+    if(rt < 0) {
+        return rt;
+    }
+    if(m_buf->getSize() >= s_chunk_size && !sendOut()) {
+        return -1;
+    }
+    return rt;
+}
+
+bool CompressStream::sendOut() {
+    if(m_buf->getSize() == 0) {
+        return true;
+    }
+    m_buf->setPosition(0);
+    int rt = m_stream->writeFixSize(m_buf, m_buf->getSize());
+    m_buf->clear();
+    return rt > 0;
+}
+
+int CompressStream::write(const void* buffer, size_t length) {
+    if(compress((const char*)buffer, length, Codec::NONE) < 0) {
+        return -1;
+    }
+    return length;
+}
+
+int CompressStream::write(ByteArray::ptr byte_arr, size_t length) {
+    std::vector<iovec> iovs;
+    length = byte_arr->getReadBuffers(iovs, length);
+    for(auto& iov : iovs) {
+        if(compress((const char*)iov.iov_base, iov.iov_len, Codec::NONE) < 0) {
+            return -1;
+        }
+    }
+    byte_arr->setPosition(byte_arr->getPosition() + length);
+    return length;
+}
+
+bool CompressStream::flush() {
+    if(compress(nullptr, 0, Codec::FLUSH) != 0) {
+        return false;
+    }
+    return sendOut();
+}
+
+bool CompressStream::finish() {
+    if(m_mode != COMPRESS || m_finished) {
+        return true;
+    }
+    int rt = compress(nullptr, 0, Codec::FINISH);
+    m_finished = true;
+    if(rt != 0) {
+        return false;
+    }
+    return sendOut();
+}
+
+void CompressStream::close() {
+    finish();
+    if(m_owner && m_stream) {
+        m_stream->close();
+    }
+}
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "stream.h"
+#include <memory>
+
+namespace FL {
+
+/**
+ * @brief 流式压缩/解压编码器
+ */
+class Codec {
+  public:
+    typedef std::shared_ptr<Codec> ptr;
+
+    enum Flush {
+        NONE = 0,   // 普通输入
+        FLUSH,      // 输出已输入数据对应的全部压缩数据, 流可以继续
+        FINISH      // 结束压缩流
+    };
+
+    virtual ~Codec() {}
+
+    /**
+     * @brief 处理一段输入, 产生一段输出
+     *
+     * @param[in,out] in 输入数据, 返回时指向未消耗的部分
+     * @param[in,out] in_len 输入长度, 返回时为未消耗的长度
+     * @param[in,out] out 输出缓冲, 返回时指向未使用的部分
+     * @param[in,out] out_len 输出缓冲长度, 返回时为未使用的长度
+     * @param[in] flush 刷新方式
+     *
+     * @return <0 出错, =0 flush/finish已完成或解压时数据流结束, >0 还需要继续调用
+     */
+    virtual int process(const char*& in, size_t& in_len, char*& out, size_t& out_len, Flush flush) = 0;
+};
+
+/**
+ * @brief 压缩流, 包装另一个Stream, 写入时压缩或读取时解压
+ */
+class CompressStream : public Stream {
+  public:
+    typedef std::shared_ptr<CompressStream> ptr;
+
+    enum Type {
+        DEFLATE = 0,    // 裸deflate
+        ZLIB,           // zlib格式
+        GZIP,           // gzip格式
+#ifdef FL_HAVE_ZSTD
+        ZSTD,           // zstd格式(CMake选项FL_WITH_ZSTD)
+#endif
+    };
+
+    enum Mode {
+        COMPRESS = 0,   // write时压缩后写入被包装的流
+        DECOMPRESS      // read时从被包装的流读取后解压
+    };
+
+    /**
+     * @brief 创建编码器
+     *
+     * @param[in] type 压缩格式
+     * @param[in] mode 压缩或解压
+     * @param[in] level 压缩级别, -1为格式默认值
+     *
+     * @return 编码器, 初始化失败返回nullptr
+     */
+    static Codec::ptr CreateCodec(Type type, Mode mode, int level = -1);
+
+    /**
+     * @brief 压缩in中可读的数据追加到out, 输入输出都按节点处理, 不合并成连续内存
+     *
+     * @return 是否成功
+     */
+    static bool Compress(ByteArray& in, ByteArray& out, Type type = GZIP, int level = -1);
+    static bool Decompress(ByteArray& in, ByteArray& out, Type type = GZIP);
+
+    /**
+     * @brief 构造函数
+     *
+     * @param[in] stream 被包装的流
+     * @param[in] type 压缩格式
+     * @param[in] mode 压缩或解压
+     * @param[in] level 压缩级别
+     * @param[in] owner 关闭时是否关闭被包装的流
+     */
+    CompressStream(Stream::ptr stream, Type type, Mode mode, int level = -1, bool owner = true);
+    virtual ~CompressStream();
+
+    virtual int read(void* buffer, size_t length) override;
+    virtual int read(ByteArray::ptr byte_arr, size_t length) override;
+
+    virtual int write(const void* buffer, size_t length) override;
+    virtual int write(ByteArray::ptr byte_arr, size_t length) override;
+
+    /**
+     * @brief 将已写入数据对应的压缩数据全部发送, 压缩流可以继续写入
+     *
+     * @return 是否成功
+     */
+    bool flush();
+
+    /**
+     * @brief 结束压缩流(写出尾部), 之后不能再写入
+     *
+     * @return 是否成功
+     */
+    bool finish();
+
+    /**
+     * @brief 压缩模式下先finish, owner为true时关闭被包装的流
+     */
+    virtual void close() override;
+
+    Stream::ptr getStream() const {
+        return m_stream;
+    }
+    bool isValid() const {
+        return m_codec != nullptr;
+    }
+  private:
+    int  compress(const char* buf, size_t len, Codec::Flush flush);
+    // 发送m_buf中全部压缩数据
+    bool sendOut();
+  private:
+    Stream::ptr     m_stream;       // 被包装的流
+    Codec::ptr      m_codec;        // 编码器
+    Mode            m_mode;         // 压缩或解压
+    bool            m_owner;        // 是否关闭被包装的流
+    bool            m_finished;     // 压缩流已结束/解压已读到结尾
+    ByteArray::ptr  m_buf;          // 压缩:待发送的压缩数据 解压:已读取未解压的数据
+};
+
+}
@@ -57,7 +57,7 @@ class LexicalCast<std::string, std::vector<T> > {
 
         for(auto it : node) {
             ss.str("");
-            ss << *it;
+            ss << it;
             vec.push_back(LexicalCast<std::string, T>()(ss.str()));
         }
 
@@ -0,0 +1,133 @@
+#include "epoch.h"
+#include "mutex.h"
+
+#include <atomic>
+#include <vector>
+
+namespace FL {
+
+namespace {
+
+// 每个线程一个槽位, 独占缓存行; 槽位只增不减, 线程退出后留给新线程复用
+struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch{0};     // 读者进入时的纪元, 0表示不在读区间内
+    std::atomic<bool> used{false};      // 是否已被某个线程占用
+    Slot* next = nullptr;
+};
+
+struct Retired {
+    uint64_t epoch;                     // 退休时的纪元
+    std::function<void()> cb;
+};
+
+std::atomic<Slot*> s_slots{nullptr};
+std::atomic<uint64_t> s_epoch{1};
+
+// 退休链表在其它编译单元的静态初始化中就可能用到, 放在函数内按需构造
+Mutex& GetMutex() {
+    static Mutex s_mutex;
+    return s_mutex;
+}
+
+std::vector<Retired>& GetRetired() {
+    static std::vector<Retired> s_retired;
+    return s_retired;
+}
+
+class LocalSlot {
+  public:
+    LocalSlot() {
+        for(Slot* slot = s_slots.load(std::memory_order_acquire); slot; slot = slot->next) {
+            bool used = false;
+            if(!slot->used.load(std::memory_order_relaxed)
+                    && slot->used.compare_exchange_strong(used, true)) {
+                m_slot = slot;
+                return;
+            }
+        }
+        m_slot = new Slot;
+        m_slot->used.store(true, std::memory_order_relaxed);
+        Slot* head = s_slots.load(std::memory_order_relaxed);
+        do {
+            m_slot->next = head;
+        } while(!s_slots.compare_exchange_weak(head, m_slot
+                                               , std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    ~LocalSlot() {
+        m_slot->epoch.store(0, std::memory_order_release);
+        m_slot->used.store(false, std::memory_order_release);
+    }
+
+    Slot* slot() const {
+        return m_slot;
+    }
+
+    uint32_t depth = 0;                 // 读区间嵌套深度
+  private:
+    Slot* m_slot;
+};
+
+LocalSlot& GetLocalSlot() {
+    static thread_local LocalSlot t_slot;
+    return t_slot;
+}
+
+}
+
+void Epoch::Enter() {
+    LocalSlot& local = GetLocalSlot();
+    if(local.depth++ == 0) {
+        local.slot()->epoch.store(s_epoch.load(), std::memory_order_relaxed);
+        // 与Reclaim中的fence配对: 写者扫描时没有看到本槽位, 则之后读到的一定是新快照
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void Epoch::Leave() {
+    LocalSlot& local = GetLocalSlot();
+    if(--local.depth == 0) {
+        local.slot()->epoch.store(0, std::memory_order_release);
+    }
+}
+
+void Epoch::Retire(std::function<void()> cb) {
+    {
+        Mutex::Lock lock(GetMutex());
+        GetRetired().push_back(Retired{s_epoch.fetch_add(1), std::move(cb)});
+    }
+    Reclaim();
+}
+
+void Epoch::Reclaim() {
+    // 只处理扫描开始前已经退休的快照, 扫描之后才退休的可能有漏掉的读者
+    uint64_t min_epoch = s_epoch.load();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for(Slot* slot = s_slots.load(std::memory_order_acquire); slot; slot = slot->next) {
+        uint64_t epoch = slot->epoch.load(std::memory_order_acquire);
+        if(epoch && epoch < min_epoch) {
+            min_epoch = epoch;
+        }
+    }
+
+    // 在纪元min_epoch之前退休的快照已经没有读者
+    std::vector<Retired> expired;
+    {
+        Mutex::Lock lock(GetMutex());
+        auto& retired = GetRetired();
+        auto it = retired.begin();
+        while(it != retired.end()) {
+            if(it->epoch < min_epoch) {
+                expired.push_back(std::move(*it));
+                it = retired.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for(auto& i : expired) {
+        i.cb();
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+
+#include "noncopyable.h"
+
+namespace FL {
+
+/**
+ * @brief 基于纪元的延迟回收, 用于以std::atomic<const T*>发布的只读快照
+ *
+ * @details 读者用Epoch::Guard包住对快照的访问, 进入和离开时只写本线程的槽位,
+ *          不加锁也不修改快照的引用计数; 写者发布新快照后把旧快照交给Retire,
+ *          等所有可能读到旧快照的读者都离开后才释放.
+ *          读区间可以嵌套, 但读区间内不能切换协程
+ */
+class Epoch {
+  public:
+    /**
+     * @brief 读区间, 析构时离开
+     */
+    class Guard : NonCopyable {
+      public:
+        Guard() {
+            Epoch::Enter();
+        }
+        ~Guard() {
+            Epoch::Leave();
+        }
+    };
+
+    /**
+     * @brief 进入读区间
+     */
+    static void Enter();
+
+    /**
+     * @brief 离开读区间
+     */
+    static void Leave();
+
+    /**
+     * @brief 延迟执行释放操作
+     *
+     * @param[in] cb 释放操作, 在调用Retire之前进入的读区间全部离开后执行
+     *
+     * @details 调用前旧快照必须已经从原子指针上摘下, 之后进入的读者不会再读到它
+     */
+    static void Retire(std::function<void()> cb);
+
+    /**
+     * @brief 延迟delete一个快照
+     */
+    template <class T>
+    static void Retire(const T* ptr) {
+        if(ptr) {
+            Retire([ptr]() {
+                delete ptr;
+            });
+        }
+    }
+
+    /**
+     * @brief 释放已经没有读者的快照, Retire时会自动调用
+     */
+    static void Reclaim();
+};
+
+}
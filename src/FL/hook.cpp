@@ -34,6 +34,7 @@ static thread_local bool t_hook_enable = false;
 	XX(send)		\
 	XX(sendto)		\
 	XX(sendmsg)		\
+	XX(sendfile)	\
 	XX(close)		\
 	XX(fcntl)		\
 	XX(ioctl)		\
@@ -100,16 +101,21 @@ static ssize_t do_io(int fd, OriginFun fun, const char* hook_fun_name
     }
 
     uint64_t to = ctx->getTimeout(timeout_so);
-    std::shared_ptr<timer_info> tinfo(new timer_info);
+    // 只有需要等待时才创建, 一次就完成的调用不分配内存
+    std::shared_ptr<timer_info> tinfo;
 
 retry:
     ssize_t n = fun(fd, std::forward<Args>(args)...);
-    while(n == -1 && errno == EAGAIN) {
+    // 被信号打断时直接重试; EAGAIN说明需要等待, 注册事件后让出协程, 就绪后回到retry
+    while(n == -1 && errno == EINTR) {
         n = fun(fd, std::forward<Args>(args)...);
     }
     if(n == -1 && errno == EAGAIN) {
         IOManager* iom = IOManager::GetThis();
         Timer::ptr timer;
+        if(!tinfo) {
+            tinfo = std::make_shared<timer_info>();
+        }
         std::weak_ptr<timer_info> winfo(tinfo);
 
         if(to != (uint64_t) -1) {
@@ -125,8 +131,8 @@ retry:
 
         int res = iom->addEvent(fd, (IOManager::Event)(event));
         if(res) {
-            FL_LOG_ERROR(FL_SYS_LOG()) << hook_fun_name << " addEvent("
-                                       << fd << ", " << event << ")";
+            FL_LOG_ERROR_RATE(FL_SYS_LOG(), 10) << hook_fun_name << " addEvent("
+                                                << fd << ", " << event << ")";
             if(timer) {
                 timer->cancel();
             }
@@ -328,6 +334,10 @@ extern "C" {
         return do_io(__fd, sendmsg_f, "sendmsg", IOManager::WRITE, SO_SNDTIMEO, __message, __flags);
     }
 
+    ssize_t sendfile(int __out_fd, int __in_fd, off_t *__offset, size_t __count) {
+        return do_io(__out_fd, sendfile_f, "sendfile", IOManager::WRITE, SO_SNDTIMEO, __in_fd, __offset, __count);
+    }
+
     int close(int fd) {
         if(!t_hook_enable) {
             return close_f(fd);
@@ -457,8 +467,10 @@ extern "C" {
             if(__optname == SO_RCVTIMEO || __optname == SO_SNDTIMEO) {
                 FL::FdCtx::ptr ctx = FL::fd_manager::GetInstance()->get(__fd);
                 if(ctx) {
+                    // 与内核一致, 全0的timeval表示不超时
                     const timeval* v = (const timeval*)__optval;
-                    ctx->setTimeout(__optname, v->tv_sec * 1000 + v->tv_usec / 1000);
+                    ctx->setTimeout(__optname, (v->tv_sec || v->tv_usec)
+                                    ? v->tv_sec * 1000 + v->tv_usec / 1000 : (uint64_t)-1);
                 }
             }
         }
@@ -4,6 +4,7 @@
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
 #include <sys/uio.h>
 #include <stdint.h>
 #include <time.h>
@@ -72,6 +73,9 @@ extern "C" {
     typedef ssize_t (*sendmsg_fun) (int __fd, const struct msghdr *__message, int __flags);
     extern sendmsg_fun sendmsg_f;
 
+    typedef ssize_t (*sendfile_fun) (int __out_fd, int __in_fd, off_t *__offset, size_t __count);
+    extern sendfile_fun sendfile_f;
+
     typedef int (*close_fun) (int __fd);
     extern close_fun close_f;
 
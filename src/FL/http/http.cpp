@@ -1,5 +1,7 @@
 #include "http.h"
 #include <sstream>
+#include <string.h>
+#include <unistd.h>
 
 namespace FL {
 namespace http {
@@ -85,119 +87,193 @@ const char* HttpStatusToString(const HttpStatus&  s) {
     return "<statu unkonw>";
 }
 
-bool CaseInsensitiveLess::operator()(const std::string& lhs, const std::string& rhs) const {
-    return strcasecmp(lhs.c_str(), rhs.c_str()) < 0;
-}
-
-HttpRequest::HttpRequest(uint8_t version, bool close)
+HttpRequest::HttpRequest(uint8_t version, bool close, std::pmr::memory_resource* mr)
     : m_method(HttpMethod::GET)
     , m_version(version)
     , m_close(close)
-    , m_path("/") {
+    , m_path("/")
+    , m_headers(mr)
+    , m_params(mr)
+    , m_cookies(mr)
+    , m_paramParsed(false)
+    , m_cookieParsed(false) {
 }
 
-std::string HttpRequest::getHeader(const std::string & key, const std::string & def) {
-    auto it = m_headers.find(key);
-    return it != m_headers.end() ? it->second : def;
+std::string HttpRequest::getHeader(std::string_view key, const std::string& def) {
+    std::string_view val;
+    return m_headers.find(key, val) ? std::string(val) : def;
 }
 
-std::string HttpRequest::getParam(const std::string& key, const std::string& def) {
-    auto it = m_params.find(key);
-    return it != m_params.end() ? it->second : def;
+std::string HttpRequest::getParam(std::string_view key, const std::string& def) {
+    initParam();
+    std::string_view val;
+    return m_params.find(key, val) ? std::string(val) : def;
 }
 
-std::string HttpRequest::getCookie(const std::string& key, const std::string& def) {
-    auto it = m_cookies.find(key);
-    return it != m_cookies.end() ? it->second : def;
+std::string HttpRequest::getCookie(std::string_view key, const std::string& def) {
+    initCookies();
+    std::string_view val;
+    return m_cookies.find(key, val) ? std::string(val) : def;
 }
 
-void HttpRequest::setHeader(const std::string& key, const std::string& val) {
-    m_headers[key] = val;
+void HttpRequest::setHeader(std::string_view key, std::string_view val) {
+    m_headers.set(key, val);
 }
 
-void  HttpRequest::setParam(const std::string& key, const std::string& val) {
-    m_params[key] = val;
+void  HttpRequest::setParam(std::string_view key, std::string_view val) {
+    m_params.set(key, val);
 }
 
-void HttpRequest::setCookie(const std::string& key, const std::string& val) {
-    m_cookies[key] = val;
+void HttpRequest::setCookie(std::string_view key, std::string_view val) {
+    m_cookies.set(key, val);
 }
 
-void HttpRequest::delHeader(const std::string& key) {
-    m_headers.erase(key);
+void HttpRequest::delHeader(std::string_view key) {
+    m_headers.del(key);
 }
 
-void HttpRequest::delParam (const std::string& key) {
-    m_params.erase(key);
+void HttpRequest::delParam (std::string_view key) {
+    m_params.del(key);
 }
 
-void HttpRequest::delCookie(const std::string& key) {
-    m_cookies.erase(key);
+void HttpRequest::delCookie(std::string_view key) {
+    m_cookies.del(key);
 }
 
-bool HttpRequest::hasHeader(const std::string& key, std::string* val) {
-    auto it = m_headers.find(key);
-    if(it == m_headers.end()) {
+static bool HasField(const HttpHeaders& map, std::string_view key, std::string* val) {
+    std::string_view str;
+    if(!map.find(key, str)) {
         return false;
     }
     if(val) {
-        *val = it->second;
+        val->assign(str.data(), str.size());
     }
     return true;
 }
 
-bool HttpRequest::hasParam (const std::string& key, std::string* val) {
-    auto it = m_params.find(key);
-    if(it == m_params.end()) {
-        return false;
-    }
-    if(val) {
-        *val = it->second;
+bool HttpRequest::hasHeader(std::string_view key, std::string* val) {
+    return HasField(m_headers, key, val);
+}
+
+bool HttpRequest::hasParam (std::string_view key, std::string* val) {
+    initParam();
+    return HasField(m_params, key, val);
+}
+
+bool HttpRequest::hasCookie(std::string_view key, std::string* val) {
+    initCookies();
+    return HasField(m_cookies, key, val);
+}
+
+// 按'&'拆分a=b&c=d, 解码后加入map
+static void ParseUrlEncoded(HttpHeaders& map, std::string_view str) {
+    while(!str.empty()) {
+        size_t end = str.find('&');
+        std::string_view item = str.substr(0, end);
+        str = end == std::string_view::npos ? std::string_view() : str.substr(end + 1);
+        if(item.empty()) {
+            continue;
+        }
+        size_t eq = item.find('=');
+        if(eq == std::string_view::npos) {
+            map.addUrlDecoded(item, std::string_view());
+        } else {
+            map.addUrlDecoded(item.substr(0, eq), item.substr(eq + 1));
+        }
     }
-    return true;
 }
 
-bool HttpRequest::hasCookie(const std::string& key, std::string* val) {
-    auto it = m_cookies.find(key);
-    if(it == m_cookies.end()) {
-        return false;
+void HttpRequest::initParam() {
+    if(m_paramParsed) {
+        return;
     }
-    if(val) {
-        *val = it->second;
+    m_paramParsed = true;
+    ParseUrlEncoded(m_params, m_query);
+
+    std::string_view type = m_headers.get("content-type");
+    static const std::string_view s_form = "application/x-www-form-urlencoded";
+    if(!m_body.empty() && type.size() >= s_form.size()
+            && strncasecmp(type.data(), s_form.data(), s_form.size()) == 0) {
+        ParseUrlEncoded(m_params, m_body);
     }
-    return true;
 }
 
-std::ostream & HttpRequest::dump(std::ostream& os) const {
-    os << HttpMethodToString(m_method) << " "
-       << m_path
-       << (m_query.empty() ? "" : "?")
-       << m_query
-       << (m_fragment.empty() ? "" : "#")
-       << m_fragment
-       << " HTTP/"
-       << ((uint32_t)(m_version >> 4))
-       << "."
-       << ((uint32_t)(m_version & 0x0F))
-       << "\r\n";
-
-    os << "connection: " << (m_close ? "close" : "keep-alive") << "\r\n";
-
-    for(auto& it : m_headers) {
-        if(strcasecmp(it.first.c_str(), "connection") == 0) {
+static std::string_view Trim(std::string_view str) {
+    size_t begin = str.find_first_not_of(" \t");
+    if(begin == std::string_view::npos) {
+        return std::string_view();
+    }
+    return str.substr(begin, str.find_last_not_of(" \t") - begin + 1);
+}
+
+void HttpRequest::initCookies() {
+    if(m_cookieParsed) {
+        return;
+    }
+    m_cookieParsed = true;
+    // Cookie: a=1; b=2, 值原样保存不做解码
+    std::string_view str = m_headers.get("cookie");
+    while(!str.empty()) {
+        size_t end = str.find(';');
+        std::string_view item = Trim(str.substr(0, end));
+        str = end == std::string_view::npos ? std::string_view() : str.substr(end + 1);
+        size_t eq = item.find('=');
+        if(eq == std::string_view::npos || eq == 0) {
             continue;
         }
-        os << it.first << ": " << it.second << "\r\n";
+        std::string_view key = Trim(item.substr(0, eq));
+        std::string_view val = Trim(item.substr(eq + 1));
+        if(!m_cookies.has(key)) {
+            m_cookies.set(key, val);
+        }
     }
+}
+
+static bool IsField(std::string_view key, std::string_view name) {
+    return key.size() == name.size() && strncasecmp(key.data(), name.data(), name.size()) == 0;
+}
 
+static void AppendVersion(std::string& buf, uint8_t version) {
+    buf.append("HTTP/");
+    buf.push_back('0' + (version >> 4));
+    buf.push_back('.');
+    buf.push_back('0' + (version & 0x0F));
+}
+
+void HttpRequest::encodeHead(std::string& buf) const {
+    buf.append(HttpMethodToString(m_method));
+    buf.push_back(' ');
+    buf.append(m_path);
+    if(!m_query.empty()) {
+        buf.push_back('?');
+        buf.append(m_query);
+    }
+    if(!m_fragment.empty()) {
+        buf.push_back('#');
+        buf.append(m_fragment);
+    }
+    buf.push_back(' ');
+    AppendVersion(buf, m_version);
+    buf.append("\r\n");
+
+    buf.append("connection: ").append(m_close ? "close" : "keep-alive").append("\r\n");
+    for(auto it : m_headers) {
+        if(IsField(it.first, "connection")
+                || (!m_body.empty() && IsField(it.first, "content-length"))) {
+            continue;
+        }
+        buf.append(it.first).append(": ").append(it.second).append("\r\n");
+    }
     if(!m_body.empty()) {
-        os << "content-length: " << m_body.size() << "\r\n\r\n"
-           << m_body;
-    } else {
-        os << "\r\n";
+        buf.append("content-length: ").append(std::to_string(m_body.size())).append("\r\n");
     }
+    buf.append("\r\n");
+}
 
-    return os;
+std::ostream & HttpRequest::dump(std::ostream& os) const {
+    std::string head;
+    encodeHead(head);
+    return os << head << m_body;
 }
 
 std::string HttpRequest::toString() const {
@@ -207,50 +283,79 @@ std:
     return ss.str();
 }
 
-HttpResponse::HttpResponse(uint8_t version, bool close)
+HttpResponse::HttpResponse(uint8_t version, bool close, std::pmr::memory_resource* mr)
     : m_status(HttpStatus::OK)
     , m_version(version)
-    , m_close(close) {
+    , m_close(close)
+    , m_fileOffset(0)
+    , m_fileLength(0)
+    , m_headers(mr) {
 }
 
-std::string HttpResponse::getHeader(const std::string& key, const std::string& def) const {
-    auto it = m_headers.find(key);
-    return it != m_headers.end() ? it->second : def;
+std::string HttpResponse::getHeader(std::string_view key, const std::string& def) const {
+    std::string_view val;
+    return m_headers.find(key, val) ? std::string(val) : def;
 }
 
-void HttpResponse::setHeader(const std::string& key, const std::string& val) {
-    m_headers[key] = val;
+void HttpResponse::setHeader(std::string_view key, std::string_view val) {
+    m_headers.set(key, val);
 }
 
-void HttpResponse::delHeader(const std::string& key) {
-    m_headers.erase(key);
+void HttpResponse::delHeader(std::string_view key) {
+    m_headers.del(key);
 }
 
-std::ostream& HttpResponse::dump(std::ostream& os) const {
-    os << "HTTP/"
-       << (uint32_t)(m_version >> 4)
-       << "."
-       << (uint32_t)(m_version & 0x0F)
-       << " "
-       << (uint32_t)m_status
-       << " "
-       << (m_reason.empty() ? HttpStatusToString(m_status) : m_reason)
-       << "\r\n";
-
-    for(auto& it : m_headers) {
-        if(strcasecmp(it.first.c_str(), "coonection") == 0) {
+HttpFile::~HttpFile() {
+    if(m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+uint64_t HttpResponse::getContentLength() const {
+    if(m_file) {
+        return m_fileLength;
+    }
+    if(m_bodyArray) {
+        return m_bodyArray->getReadSize();
+    }
+    return m_body.size();
+}
+
+void HttpResponse::encodeHead(std::string& buf) const {
+    AppendVersion(buf, m_version);
+    buf.push_back(' ');
+    buf.append(std::to_string((uint32_t)m_status));
+    buf.push_back(' ');
+    buf.append(m_reason.empty() ? HttpStatusToString(m_status) : m_reason);
+    buf.append("\r\n");
+
+    uint64_t length = getContentLength();
+    for(auto it : m_headers) {
+        if(IsField(it.first, "connection")
+                || (length && IsField(it.first, "content-length"))) {
             continue;
         }
-        os << it.first << ": " << it.second << "\r\n";
+        buf.append(it.first).append(": ").append(it.second).append("\r\n");
     }
+    buf.append("connection: ").append(m_close ? "close" : "keep-alive").append("\r\n");
+    if(length) {
+        buf.append("content-length: ").append(std::to_string(length)).append("\r\n");
+    }
+    buf.append("\r\n");
+}
 
-    os << "connection: " << (m_close ? "close" : "keep-alive") << "\r\n";
-
-    if(!m_body.empty()) {
-        os << "content-length: " << m_body.size() << "\r\n\r\n"
-           << m_body;
-    } else {
-        os << "\r\n";
+std::ostream& HttpResponse::dump(std::ostream& os) const {
+    std::string head;
+    encodeHead(head);
+    os << head;
+    if(m_bodyArray) {
+        std::vector<iovec> iovs;
+        m_bodyArray->getReadBuffers(iovs);
+        for(auto& iov : iovs) {
+            os.write((const char*)iov.iov_base, iov.iov_len);
+        }
+    } else if(!m_file) {
+        os << m_body;
     }
     return os;
 }
@@ -3,10 +3,14 @@
 #include <memory>
 #include <string>
 #include <map>
+#include <string_view>
 #include <iostream>
 #include <sstream>
 #include <boost/lexical_cast.hpp>
 
+#include "../bytearray.h"
+#include "http_header.h"
+
 
 namespace FL {
 
@@ -139,21 +143,16 @@ HttpMethod CharsToHttpMethod  (const char*		  m);
 const char* HttpMethodToString(const HttpMethod&  m);
 const char* HttpStatusToString(const HttpStatus&  s);
 
-struct CaseInsensitiveLess {
-    bool operator()(const std::string& lhs, const std::string& rhs) const;
-};
-
-template <class Map_t, class T>
-bool checkGetAs(const Map_t& map, const std::string& key, T& val, const T& def = T()) {
-    std::string str;
-    auto it = map.find(key);
-    if(it == map.end()) {
+template <class T>
+bool checkGetAs(const HttpHeaders& map, std::string_view key, T& val, const T& def = T()) {
+    std::string_view str;
+    if(!map.find(key, str)) {
         val = def;
         return false;
     }
 
     try {
-        val = boost::lexical_cast<T>(it->second);
+        val = boost::lexical_cast<T>(str.data(), str.size());
         return true;
     } catch(...) {
         val = def;
@@ -161,28 +160,50 @@ bool checkGetAs(const Map_t& map, const std::string& key, T& val, const T& def =
     return false;
 }
 
-template <class Map_t, class T>
-T getAs(const Map_t& map, const std::string& key, const T& def = T()) {
-    auto it = map.find(key);
-    if(it == map.end()) {
+template <class T>
+T getAs(const HttpHeaders& map, std::string_view key, const T& def = T()) {
+    std::string_view str;
+    if(!map.find(key, str)) {
         return def;
     }
 
     try {
-        return boost::lexical_cast<T>(it->second);
+        return boost::lexical_cast<T>(str.data(), str.size());
     } catch(...) {
         return def;
     }
-    return false;
 }
 
+/**
+ * @brief 作为消息体发送的文件, 持有文件描述符, 析构时关闭
+ */
+class HttpFile {
+  public:
+    typedef std::shared_ptr<HttpFile> ptr;
+
+    HttpFile(int fd)
+        : m_fd(fd) {
+    }
+    ~HttpFile();
+
+    int getFd() const {
+        return m_fd;
+    }
+  private:
+    int m_fd;
+};
+
 class HttpRequest {
 
   public:
     typedef std::shared_ptr<HttpRequest> ptr;
-    typedef std::map<std::string, std::string, CaseInsensitiveLess> Map_t;
+    typedef HttpHeaders Map_t;
 
-    HttpRequest(uint8_t version = 0x11, bool close = true);
+    /**
+     * @param[in] mr 头部, 参数和cookie存储的内存来源
+     */
+    HttpRequest(uint8_t version = 0x11, bool close = true
+                , std::pmr::memory_resource* mr = std::pmr::get_default_resource());
 
     HttpMethod getMethod () const {
         return m_method;
@@ -209,10 +230,15 @@ class HttpRequest {
     const Map_t& getHeaders() const {
         return m_headers;
     }
-    const Map_t& getParam  () const {
+    /**
+     * @brief 全部参数: 路由参数, 查询参数和表单参数, 首次访问时解析
+     */
+    const Map_t& getParam  () {
+        initParam();
         return m_params;
     }
-    const Map_t& getCookies() const {
+    const Map_t& getCookies() {
+        initCookies();
         return m_cookies;
     }
 
@@ -252,52 +278,72 @@ class HttpRequest {
     }
 
 
-    std::string getHeader(const std::string& key, const std::string& def = "");
-    std::string getParam (const std::string& key, const std::string& def = "");
-    std::string getCookie(const std::string& key, const std::string& def = "");
+    std::string getHeader(std::string_view key, const std::string& def = "");
+    std::string getParam (std::string_view key, const std::string& def = "");
+    std::string getCookie(std::string_view key, const std::string& def = "");
 
-    void setHeader(const std::string& key, const std::string& val);
-    void setParam (const std::string& key, const std::string& val);
-    void setCookie(const std::string& key, const std::string& val);
+    void setHeader(std::string_view key, std::string_view val);
+    void setParam (std::string_view key, std::string_view val);
+    void setCookie(std::string_view key, std::string_view val);
 
-    void delHeader(const std::string& key);
-    void delParam (const std::string& key);
-    void delCookie(const std::string& key);
+    void delHeader(std::string_view key);
+    void delParam (std::string_view key);
+    void delCookie(std::string_view key);
 
-    bool hasHeader(const std::string& key, std::string* val = nullptr);
-    bool hasParam (const std::string& key, std::string* val = nullptr);
-    bool hasCookie(const std::string& key, std::string* val = nullptr);
+    bool hasHeader(std::string_view key, std::string* val = nullptr);
+    bool hasParam (std::string_view key, std::string* val = nullptr);
+    bool hasCookie(std::string_view key, std::string* val = nullptr);
 
     template <class T>
-    bool checkGetHaderAs(const std::string& key, T& val, const T& def = T()) {
+    bool checkGetHaderAs(std::string_view key, T& val, const T& def = T()) {
         return checkGetAs(m_headers, key, val, def);
     }
     template <class T>
-    T getHaderAs(const std::string& key, const T& def = T()) {
+    T getHaderAs(std::string_view key, const T& def = T()) {
         return getAs(m_headers, key, def);
     }
 
     template <class T>
-    bool checkGetParamAs(const std::string& key, T& val, const T& def = T()) {
+    bool checkGetParamAs(std::string_view key, T& val, const T& def = T()) {
+        initParam();
         return checkGetAs(m_params, key, val, def);
     }
     template <class T>
-    T getParamAs(const std::string& key, const T& def = T()) {
+    T getParamAs(std::string_view key, const T& def = T()) {
+        initParam();
         return getAs(m_params, key, def);
     }
 
     template <class T>
-    bool checkGetCookieAs(const std::string& key, T& val, const T& def = T()) {
+    bool checkGetCookieAs(std::string_view key, T& val, const T& def = T()) {
+        initCookies();
         return checkGetAs(m_cookies, key, val, def);
     }
     template <class T>
-    T getCookieAs(const std::string& key, const T& def = T()) {
+    T getCookieAs(std::string_view key, const T& def = T()) {
+        initCookies();
         return getAs(m_cookies, key, def);
     }
 
+    /**
+     * @brief 把请求行和头部(含空行)追加到buf, 消息体需单独发送
+     */
+    void encodeHead(std::string& buf) const;
+
     std::ostream& dump(std::ostream& os) const;
     std::string toString() const;
 
+  private:
+    /**
+     * @brief 解析查询串和application/x-www-form-urlencoded消息体到m_params
+     *
+     * @details 只在第一次访问参数时解析一次, 之后修改query或body不会重新解析.
+     *          已存在的参数(如路由参数)不会被覆盖, 查询参数优先于表单参数
+     */
+    void initParam();
+    // 解析Cookie头到m_cookies, 只解析一次
+    void initCookies();
+
   private:
     HttpMethod	m_method;
     uint8_t		m_version;
@@ -311,14 +357,18 @@ class HttpRequest {
     Map_t m_headers;
     Map_t m_params;
     Map_t m_cookies;
+
+    bool m_paramParsed;     // 是否已解析查询串和表单
+    bool m_cookieParsed;    // 是否已解析Cookie头
 };
 
 class HttpResponse {
   public:
     typedef std::shared_ptr<HttpResponse> ptr;
-    typedef std::map<std::string, std::string, CaseInsensitiveLess> Map_t;
+    typedef HttpHeaders Map_t;
 
-    HttpResponse(uint8_t version = 0x11, bool close = true);
+    HttpResponse(uint8_t version = 0x11, bool close = true
+                 , std::pmr::memory_resource* mr = std::pmr::get_default_resource());
 
     HttpStatus getStatus() const {
         return m_status;
@@ -337,6 +387,17 @@ class HttpResponse {
     const Map_t& getHeaders		() const {
         return m_headers;
     }
+    ByteArray::ptr getBodyArray() const {
+        return m_bodyArray;
+    }
+    HttpFile::ptr getFile() const {
+        return m_file;
+    }
+    uint64_t getFileOffset() const {
+        return m_fileOffset;
+    }
+    // 消息体长度, 与消息体来源无关
+    uint64_t getContentLength() const;
 
     void setStatus (HttpStatus val) {
         m_status = val;
@@ -347,6 +408,26 @@ class HttpResponse {
 
     void setBody  (const std::string& val) {
         m_body = val;
+        m_bodyArray.reset();
+        m_file.reset();
+    }
+    /**
+     * @brief 以byte_arr中未读的数据作为消息体, 发送时直接引用其节点, 不移动读位置
+     */
+    void setBody  (ByteArray::ptr val) {
+        m_body.clear();
+        m_bodyArray = val;
+        m_file.reset();
+    }
+    /**
+     * @brief 以文件区间作为消息体, 发送时使用sendfile
+     */
+    void setFileBody(HttpFile::ptr file, uint64_t offset, uint64_t length) {
+        m_body.clear();
+        m_bodyArray.reset();
+        m_file = file;
+        m_fileOffset = offset;
+        m_fileLength = length;
     }
     void setReason(const std::string& val) {
         m_reason = val;
@@ -363,20 +444,25 @@ class HttpResponse {
         m_close = val;
     }
 
-    std::string getHeader(const std::string& key, const std::string& def = "") const;
-    void setHeader(const std::string& key, const std::string& val);
-    void delHeader(const std::string& key);
+    std::string getHeader(std::string_view key, const std::string& def = "") const;
+    void setHeader(std::string_view key, std::string_view val);
+    void delHeader(std::string_view key);
 
     template <class T>
-    bool checkGetHaderAs(const std::string& key, const T& def = T()) {
-        return checkGetAs(m_headers, key, def);
+    bool checkGetHaderAs(std::string_view key, T& val, const T& def = T()) {
+        return checkGetAs(m_headers, key, val, def);
     }
 
     template <class T>
-    T getHaderAs(const std::string& key, const T& def = T()) {
+    T getHaderAs(std::string_view key, const T& def = T()) {
         return getAs(m_headers, key, def);
     }
 
+    /**
+     * @brief 把状态行和头部(含空行)追加到buf, 消息体需单独发送
+     */
+    void encodeHead(std::string& buf) const;
+
     std::ostream& dump(std::ostream& os) const;
     std::string toString() const;
   private:
@@ -387,6 +473,11 @@ class HttpResponse {
     std::string m_body;
     std::string	m_reason;
 
+    ByteArray::ptr m_bodyArray;     // ByteArray消息体
+    HttpFile::ptr  m_file;          // 文件消息体
+    uint64_t       m_fileOffset;
+    uint64_t       m_fileLength;
+
     Map_t		m_headers;
 };
 
@@ -124,11 +124,16 @@ HttpResponse::ptr HttpConnection::recvResponse() {
     return parser->getData();
 }
 
-int HttpConnection::sendRequest(HttpRequest::ptr rsp) {
-    std::stringstream ss;
-    ss << *rsp;
-    std::string data = ss.str();
-    return writeFixSize(data.c_str(), data.size());
+int64_t HttpConnection::sendRequest(HttpRequest::ptr req) {
+    m_sendBuf.clear();
+    req->encodeHead(m_sendBuf);
+
+    m_writeIovs.clear();
+    m_writeIovs.push_back({&m_sendBuf[0], m_sendBuf.size()});
+    if(!req->getBody().empty()) {
+        m_writeIovs.push_back({(void*)req->getBody().c_str(), req->getBody().size()});
+    }
+    return writeFixIovs(m_writeIovs);
 }
 
 HttpResult::ptr HttpConnection::DoGet(const std::string& url
@@ -237,7 +242,7 @@ HttpResult::ptr HttpConnection::DoRequest(HttpRequest::ptr req
     sock->setRecvTimeout(timeout);
 
     HttpConnection::ptr conn(new HttpConnection(sock));
-    int rt = conn->sendRequest(req);
+    int64_t rt = conn->sendRequest(req);
     if(rt == 0) {
         return 	HttpResult::ptr(new HttpResult(HttpResult::Result::SEND_FAIL
                                                , nullptr
@@ -395,7 +400,7 @@ HttpResult::ptr HttpConnectionPool::doRequest(HttpRequest::ptr req
                                                , "pool host: " +  m_host + " port: " + std::to_string(m_port)));
     }
     sock->setRecvTimeout(timeout);
-    int rt = conn->sendRequest(req);
+    int64_t rt = conn->sendRequest(req);
     if(rt == 0) {
         return 	HttpResult::ptr(new HttpResult(HttpResult::Result::SEND_FAIL
                                                , nullptr
@@ -45,7 +45,11 @@ class HttpConnection : public SocketStream {
 
     HttpConnection(Socket::ptr sock, bool owner = true);
     HttpResponse::ptr recvResponse();
-    int sendRequest(HttpRequest::ptr req);
+
+    /**
+     * @brief 发送请求, 头部和消息体一次sendmsg发出, 消息体不复制
+     */
+    int64_t sendRequest(HttpRequest::ptr req);
 
     static HttpResult::ptr DoGet(const std::string& url
                                  , uint64_t timeout
@@ -84,6 +88,7 @@ class HttpConnection : public SocketStream {
                                      , Uri::ptr uri
                                      , uint64_t timeout);
   private:
+    std::string m_sendBuf;  // 请求头部缓冲区
 };
 
 class HttpConnectionPool {
@@ -0,0 +1,224 @@
+#include "http_header.h"
+#include <string.h>
+#include <strings.h>
+
+namespace FL {
+namespace http {
+
+// 第一次写入时预留的存储, 足够容纳常见请求的全部头部
+static constexpr size_t s_init_data_size = 1024;
+
+HttpHeaders::HttpHeaders(std::pmr::memory_resource* mr)
+    : m_data(mr)
+    , m_heap(nullptr)
+    , m_size(0)
+    , m_capacity(INLINE_SIZE) {
+}
+
+HttpHeaders::HttpHeaders(const HttpHeaders& other)
+    : HttpHeaders() {
+    *this = other;
+}
+
+HttpHeaders& HttpHeaders::operator=(const HttpHeaders& other) {
+    if(this == &other) {
+        return *this;
+    }
+    m_data = other.m_data;
+    if(other.m_size > m_capacity) {
+        freeHeap();
+        m_heap = allocEntries(other.m_size);
+        m_capacity = other.m_size;
+    }
+    memcpy(entries(), other.entries(), other.m_size * sizeof(Entry));
+    m_size = other.m_size;
+    return *this;
+}
+
+HttpHeaders::~HttpHeaders() {
+    freeHeap();
+}
+
+HttpHeaders::Entry* HttpHeaders::allocEntries(uint32_t n) {
+    return static_cast<Entry*>(m_data.get_allocator().resource()->allocate(
+                n * sizeof(Entry), alignof(Entry)));
+}
+
+void HttpHeaders::freeHeap() {
+    if(m_heap) {
+        m_data.get_allocator().resource()->deallocate(m_heap, m_capacity * sizeof(Entry), alignof(Entry));
+        m_heap = nullptr;
+    }
+}
+
+uint32_t HttpHeaders::hash(std::string_view key) {
+    uint32_t h = 2166136261u;
+    for(char c : key) {
+        h ^= (uint8_t)(c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int HttpHeaders::indexOf(std::string_view key, uint32_t h) const {
+    const Entry* e = entries();
+    const char* data = m_data.data();
+    for(uint32_t i = 0; i < m_size; ++i) {
+        if(e[i].hash == h && e[i].keyLength == key.size()
+                && strncasecmp(data + e[i].keyOffset, key.data(), key.size()) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint32_t HttpHeaders::append(std::string_view str) {
+    if(m_data.capacity() < s_init_data_size) {
+        m_data.reserve(s_init_data_size);
+    }
+    uint32_t offset = m_data.size();
+    m_data.append(str.data(), str.size());
+    return offset;
+}
+
+bool HttpHeaders::find(std::string_view key, std::string_view& val) const {
+    int idx = indexOf(key, hash(key));
+    if(idx < 0) {
+        return false;
+    }
+    const Entry& e = entries()[idx];
+    val = std::string_view(m_data.data() + e.valOffset, e.valLength);
+    return true;
+}
+
+std::string_view HttpHeaders::get(std::string_view key, std::string_view def) const {
+    std::string_view val;
+    return find(key, val) ? val : def;
+}
+
+void HttpHeaders::set(std::string_view key, std::string_view val) {
+    const char* begin = m_data.data();
+    const char* end = begin + m_data.size();
+    if((key.data() >= begin && key.data() < end) || (val.data() >= begin && val.data() < end)) {
+        // 参数引用自身存储时, 扩充存储会使其失效
+        std::string tmp_key(key);
+        std::string tmp_val(val);
+        set(tmp_key, tmp_val);
+        return;
+    }
+    uint32_t h = hash(key);
+    int idx = indexOf(key, h);
+    if(idx >= 0) {
+        Entry& e = entries()[idx];
+        if(val.size() <= e.valLength) {
+            // 新值不更长时原地覆盖
+            memmove(&m_data[e.valOffset], val.data(), val.size());
+        } else {
+            e.valOffset = append(val);
+        }
+        e.valLength = val.size();
+        return;
+    }
+
+    Entry& e = newEntry();
+    e.hash = h;
+    e.keyLength = key.size();
+    e.keyOffset = append(key);
+    e.valLength = val.size();
+    e.valOffset = append(val);
+}
+
+HttpHeaders::Entry& HttpHeaders::newEntry() {
+    if(m_size == m_capacity) {
+        uint32_t cap = m_capacity * 2;
+        Entry* heap = allocEntries(cap);
+        memcpy(heap, entries(), m_size * sizeof(Entry));
+        freeHeap();
+        m_heap = heap;
+        m_capacity = cap;
+    }
+    return entries()[m_size++];
+}
+
+static int HexValue(char c) {
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+uint32_t HttpHeaders::appendUrlDecoded(std::string_view str, bool plus_as_space) {
+    if(m_data.capacity() < s_init_data_size) {
+        m_data.reserve(s_init_data_size);
+    }
+    // 解码结果不会比原文长, 先按原文长度扩展, 再在新区域内原地写入
+    size_t offset = m_data.size();
+    m_data.resize(offset + str.size());
+    char* out = &m_data[offset];
+    char* p = out;
+    for(size_t i = 0; i < str.size(); ++i) {
+        char c = str[i];
+        if(c == '%' && i + 2 < str.size()
+                && HexValue(str[i + 1]) >= 0 && HexValue(str[i + 2]) >= 0) {
+            *p++ = (char)(HexValue(str[i + 1]) << 4 | HexValue(str[i + 2]));
+            i += 2;
+        } else if(c == '+' && plus_as_space) {
+            *p++ = ' ';
+        } else {
+            *p++ = c;
+        }
+    }
+    uint32_t len = p - out;
+    m_data.resize(offset + len);
+    return len;
+}
+
+bool HttpHeaders::addUrlDecoded(std::string_view key, std::string_view val, bool plus_as_space) {
+    uint32_t key_offset = m_data.size();
+    uint32_t key_length = appendUrlDecoded(key, plus_as_space);
+    std::string_view decoded_key(m_data.data() + key_offset, key_length);
+    uint32_t h = hash(decoded_key);
+    if(indexOf(decoded_key, h) >= 0) {
+        m_data.resize(key_offset);
+        return false;
+    }
+    uint32_t val_offset = m_data.size();
+    uint32_t val_length = appendUrlDecoded(val, plus_as_space);
+
+    Entry& e = newEntry();
+    e.hash = h;
+    e.keyOffset = key_offset;
+    e.keyLength = key_length;
+    e.valOffset = val_offset;
+    e.valLength = val_length;
+    return true;
+}
+
+bool HttpHeaders::del(std::string_view key) {
+    int idx = indexOf(key, hash(key));
+    if(idx < 0) {
+        return false;
+    }
+    Entry* e = entries();
+    memmove(e + idx, e + idx + 1, (m_size - idx - 1) * sizeof(Entry));
+    --m_size;
+    return true;
+}
+
+void HttpHeaders::clear() {
+    m_data.clear();
+    m_size = 0;
+}
+
+std::pair<std::string_view, std::string_view> HttpHeaders::at(uint32_t idx) const {
+    const Entry& e = entries()[idx];
+    return std::make_pair(std::string_view(m_data.data() + e.keyOffset, e.keyLength)
+                          , std::string_view(m_data.data() + e.valOffset, e.valLength));
+}
+
+}
+}
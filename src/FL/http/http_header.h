@@ -0,0 +1,143 @@
+#pragma once
+
+#include <memory_resource>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace FL {
+namespace http {
+
+/**
+ * @brief 扁平的头部容器, 键不区分大小写
+ *
+ * @details 所有键值依次追加到同一块连续存储中, 条目只记录偏移, 长度和键的
+ *          小写哈希; 条目数不超过INLINE_SIZE时保存在对象内部. 解析一个十几个
+ *          头部的请求只需要扩充存储一两次, 不再为每个头部分配树节点和两个字符串.
+ *          查找按哈希线性比较, 头部数量较少时比std::map更快.
+ *          同名键后设置的覆盖先设置的, 迭代顺序为插入顺序
+ */
+class HttpHeaders {
+  public:
+    static constexpr uint32_t INLINE_SIZE = 16;
+
+    /**
+     * @param[in] mr 存储和溢出条目的内存来源, 如请求所在连接的Arena
+     */
+    explicit HttpHeaders(std::pmr::memory_resource* mr = std::pmr::get_default_resource());
+    // 拷贝总是使用默认内存来源, 以免拷贝比原来的arena活得更久
+    HttpHeaders(const HttpHeaders& other);
+    HttpHeaders& operator=(const HttpHeaders& other);
+    ~HttpHeaders();
+
+    /**
+     * @brief 查找键
+     *
+     * @param[out] val 找到时的值, 在下一次修改容器之前有效
+     */
+    bool find(std::string_view key, std::string_view& val) const;
+
+    /**
+     * @brief 查找键, 不存在时返回def
+     */
+    std::string_view get(std::string_view key, std::string_view def = std::string_view()) const;
+
+    bool has(std::string_view key) const {
+        return indexOf(key, hash(key)) >= 0;
+    }
+
+    void set(std::string_view key, std::string_view val);
+
+    /**
+     * @brief 对key和val做URL解码(%XX, 可选'+'转空格)后直接写入存储, 键已存在时不覆盖.
+     *        key和val不能引用本容器的存储
+     *
+     * @return 是否添加
+     */
+    bool addUrlDecoded(std::string_view key, std::string_view val, bool plus_as_space = true);
+
+    /**
+     * @brief 删除键, 其占用的存储在clear之前不会回收
+     */
+    bool del(std::string_view key);
+
+    void clear();
+
+    uint32_t size() const {
+        return m_size;
+    }
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    // 不区分大小写的FNV-1a哈希
+    static uint32_t hash(std::string_view key);
+
+    class const_iterator {
+      public:
+        typedef std::pair<std::string_view, std::string_view> value_type;
+
+        const_iterator(const HttpHeaders* headers, uint32_t idx)
+            : m_headers(headers)
+            , m_idx(idx) {
+        }
+        value_type operator*() const {
+            return m_headers->at(m_idx);
+        }
+        const_iterator& operator++() {
+            ++m_idx;
+            return *this;
+        }
+        bool operator!=(const const_iterator& rhs) const {
+            return m_idx != rhs.m_idx;
+        }
+        bool operator==(const const_iterator& rhs) const {
+            return m_idx == rhs.m_idx;
+        }
+      private:
+        const HttpHeaders* m_headers;
+        uint32_t m_idx;
+    };
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const {
+        return const_iterator(this, m_size);
+    }
+
+    std::pair<std::string_view, std::string_view> at(uint32_t idx) const;
+  private:
+    struct Entry {
+        uint32_t hash;
+        uint32_t keyOffset;
+        uint32_t keyLength;
+        uint32_t valOffset;
+        uint32_t valLength;
+    };
+
+    Entry* entries() {
+        return m_heap ? m_heap : m_inline;
+    }
+    const Entry* entries() const {
+        return m_heap ? m_heap : m_inline;
+    }
+    int indexOf(std::string_view key, uint32_t h) const;
+    uint32_t append(std::string_view str);
+    // 解码后追加到存储, 返回解码后的长度
+    uint32_t appendUrlDecoded(std::string_view str, bool plus_as_space);
+    // 在末尾添加一个条目, 必要时扩容
+    Entry& newEntry();
+    Entry* allocEntries(uint32_t n);
+    void freeHeap();
+  private:
+    std::pmr::string m_data;            // 键值的连续存储
+    Entry       m_inline[INLINE_SIZE];  // 内联条目
+    Entry*      m_heap;                 // 条目超过INLINE_SIZE后的堆存储
+    uint32_t    m_size;
+    uint32_t    m_capacity;
+};
+
+}
+}
@@ -86,7 +86,7 @@ void on_request_http_field(void* data, const char* field, size_t flen, const cha
         parser->setError(1002);
         return;
     }
-    parser->getData()->setHeader(std::string(field, flen), std::string(value, vlen));
+    parser->getData()->setHeader(std::string_view(field, flen), std::string_view(value, vlen));
 }
 void on_request_method(void* data, const char* at, size_t length) {
     HttpRequestParser* parser = static_cast<HttpRequestParser*>(data);
@@ -131,7 +131,15 @@ void on_request_version(void* data, const char* at, size_t length) {
     parser->getData()->setVersion(version);
 }
 void on_request_header_done(void* data, const char* at, size_t length) {
-
+    HttpRequestParser* parser = static_cast<HttpRequestParser*>(data);
+    auto req = parser->getData();
+    // HTTP/1.1默认长连接, HTTP/1.0默认短连接, 以connection头为准
+    std::string_view conn = req->getHeaders().get("connection");
+    if(conn.empty()) {
+        req->setClose(req->getVersion() != 0x11);
+    } else {
+        req->setClose(conn.size() != 10 || strncasecmp(conn.data(), "keep-alive", 10) != 0);
+    }
 }
 
 void on_response_http_field(void* data, const char* field, size_t flen, const char* value, size_t vlen) {
@@ -141,7 +149,7 @@ void on_response_http_field(void* data, const char* field, size_t flen, const ch
         parser->setError(1002);
         return;
     }
-    parser->getData()->setHeader(std::string(field, flen), std::string(value, vlen));
+    parser->getData()->setHeader(std::string_view(field, flen), std::string_view(value, vlen));
 }
 void on_response_reason(void* data, const char* at, size_t length) {
     HttpResponseParser* parser = static_cast<HttpResponseParser*>(data);
@@ -198,12 +206,23 @@ size_t HttpRequestParser::execute(char* data, size_t len) {
     size_t offset = http_parser_execute(&m_parser, data, len, 0);
     if(offset == -1) {
         FL_LOG_WARN(syslog) << "invalid request: " << std::string(data, len);
-    } else if(offset != 1) {
+    } else if(offset != 0) {
         memmove(data, data + offset, (len - offset));
     }
     return offset;
 }
 
+void HttpRequestParser::reset() {
+    reset(std::make_shared<HttpRequest>());
+}
+
+void HttpRequestParser::reset(HttpRequest::ptr req) {
+    m_error = 0;
+    m_request = std::move(req);
+    // 只重置状态, 回调和data保持不变
+    http_parser_init(&m_parser);
+}
+
 bool HttpRequestParser::isFinish() {
     return http_parser_finish(&m_parser);
 }
@@ -16,6 +16,18 @@ class HttpRequestParser {
 
     size_t execute(char* data, size_t len);
 
+    /**
+     * @brief 重置解析状态和请求对象, 用于同一连接上解析下一个请求
+     */
+    void reset();
+
+    /**
+     * @brief 重置解析状态, 解析结果写入req
+     *
+     * @param[in] req 新的请求对象, 为nullptr时只释放当前请求, 下次解析前必须再次reset
+     */
+    void reset(HttpRequest::ptr req);
+
     bool isFinish();
     bool hasError();
 
@@ -0,0 +1,188 @@
+#include "http_router.h"
+#include "http_servlet.h"
+
+#include <algorithm>
+
+namespace FL {
+namespace http {
+
+struct RadixRouter::Node {
+    std::string prefix;                             // 静态文本(合并后的边)
+    std::string indices;                            // 各静态子节点prefix的首字符
+    std::vector<std::unique_ptr<Node>> children;    // 静态子节点
+    std::unique_ptr<Node> param;                    // :name子节点, 匹配一个路径段
+    std::string paramName;
+    ServletPtr wildcard;                            // 结尾通配符
+    std::string wildcardName;
+    ServletPtr handler;                             // 在此结束的路由
+};
+
+RadixRouter::RadixRouter()
+    : m_root(new Node)
+    , m_size(0) {
+}
+
+RadixRouter::~RadixRouter() {
+}
+
+bool RadixRouter::add(const std::string& pattern, ServletPtr servlet, bool literal) {
+    std::string wildcard_name;
+    bool is_wildcard = false;
+    Node* node = insert(pattern, literal, is_wildcard, wildcard_name);
+    if(!node) {
+        return false;
+    }
+    if(is_wildcard) {
+        node->wildcard = servlet;
+        node->wildcardName = wildcard_name;
+    } else {
+        node->handler = servlet;
+    }
+    ++m_size;
+    return true;
+}
+
+bool RadixRouter::addPrefix(const std::string& prefix, ServletPtr servlet) {
+    std::string wildcard_name;
+    bool is_wildcard = false;
+    Node* node = insert(prefix, true, is_wildcard, wildcard_name);
+    node->wildcard = servlet;
+    node->wildcardName.clear();
+    ++m_size;
+    return true;
+}
+
+RadixRouter::Node* RadixRouter::insert(const std::string& pattern, bool literal
+                                       , bool& is_wildcard, std::string& wildcard_name) {
+    Node* node = m_root.get();
+    size_t pos = 0;
+    while(pos < pattern.size()) {
+        char c = pattern[pos];
+        if(!literal && c == ':') {
+            size_t end = pattern.find('/', pos);
+            if(end == std::string::npos) {
+                end = pattern.size();
+            }
+            std::string name = pattern.substr(pos + 1, end - pos - 1);
+            if(name.empty()) {
+                return nullptr;
+            }
+            if(!node->param) {
+                node->param.reset(new Node);
+                node->paramName = name;
+            } else if(node->paramName != name) {
+                return nullptr;
+            }
+            node = node->param.get();
+            pos = end;
+            continue;
+        }
+        if(!literal && c == '*') {
+            if(pattern.find('/', pos) != std::string::npos) {
+                return nullptr;
+            }
+            is_wildcard = true;
+            wildcard_name = pattern.substr(pos + 1);
+            return node;
+        }
+
+        size_t end = literal ? std::string::npos : pattern.find_first_of(":*", pos);
+        if(end == std::string::npos) {
+            end = pattern.size();
+        }
+        size_t idx = node->indices.find(c);
+        if(idx == std::string::npos) {
+            Node* child = new Node;
+            child->prefix = pattern.substr(pos, end - pos);
+            node->indices.push_back(c);
+            node->children.emplace_back(child);
+            node = child;
+            pos = end;
+            continue;
+        }
+
+        Node* child = node->children[idx].get();
+        size_t len = 0;
+        size_t max_len = std::min(child->prefix.size(), end - pos);
+        while(len < max_len && child->prefix[len] == pattern[pos + len]) {
+            ++len;
+        }
+        if(len < child->prefix.size()) {
+            // 公共前缀在child中间结束, 拆出一个中间节点
+            std::unique_ptr<Node> mid(new Node);
+            mid->prefix = child->prefix.substr(0, len);
+            child->prefix.erase(0, len);
+            mid->indices.push_back(child->prefix[0]);
+            mid->children.push_back(std::move(node->children[idx]));
+            node->children[idx] = std::move(mid);
+            child = node->children[idx].get();
+        }
+        node = child;
+        pos += len;
+    }
+    return node;
+}
+
+RadixRouter::ServletPtr RadixRouter::match(const std::string& path, Params* params, bool* wildcard) const {
+    ServletPtr out;
+    bool is_wildcard = false;
+    if(!lookup(m_root.get(), path, 0, params, &is_wildcard, out)) {
+        return nullptr;
+    }
+    if(wildcard) {
+        *wildcard = is_wildcard;
+    }
+    return out;
+}
+
+bool RadixRouter::lookup(const Node* node, const std::string& path, size_t pos
+                         , Params* params, bool* wildcard, ServletPtr& out) const {
+    if(pos == path.size() && node->handler) {
+        out = node->handler;
+        *wildcard = false;
+        return true;
+    }
+
+    if(pos < path.size()) {
+        size_t idx = node->indices.find(path[pos]);
+        if(idx != std::string::npos) {
+            const Node* child = node->children[idx].get();
+            if(path.compare(pos, child->prefix.size(), child->prefix) == 0
+                    && lookup(child, path, pos + child->prefix.size(), params, wildcard, out)) {
+                return true;
+            }
+        }
+
+        if(node->param) {
+            size_t end = path.find('/', pos);
+            if(end == std::string::npos) {
+                end = path.size();
+            }
+            if(end > pos) {
+                size_t n = params ? params->size() : 0;
+                if(params) {
+                    params->emplace_back(node->paramName, path.substr(pos, end - pos));
+                }
+                if(lookup(node->param.get(), path, end, params, wildcard, out)) {
+                    return true;
+                }
+                if(params) {
+                    params->resize(n);
+                }
+            }
+        }
+    }
+
+    if(node->wildcard) {
+        if(params && !node->wildcardName.empty()) {
+            params->emplace_back(node->wildcardName, path.substr(pos));
+        }
+        out = node->wildcard;
+        *wildcard = true;
+        return true;
+    }
+    return false;
+}
+
+}
+}
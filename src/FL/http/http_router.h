@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace FL {
+namespace http {
+
+class Servlet;
+
+/**
+ * @brief 压缩前缀树(radix tree)路由
+ *
+ * @details 路由由三种片段组成:
+ *          - 静态文本, 公共前缀合并存储
+ *          - :name 匹配一个路径段(不含'/'), 匹配结果按name输出到参数
+ *          - 结尾的 * 或 *name 匹配剩余的全部路径(可为空)
+ *          查找时静态文本优先于参数, 参数优先于通配符, 复杂度与路径长度成正比.
+ *          构建完成后只读, 多线程并发match不需要加锁
+ */
+class RadixRouter {
+  public:
+    typedef std::shared_ptr<RadixRouter> ptr;
+    typedef std::shared_ptr<Servlet> ServletPtr;
+    typedef std::vector<std::pair<std::string, std::string>> Params;
+
+    RadixRouter();
+    ~RadixRouter();
+
+    /**
+     * @brief 添加路由
+     *
+     * @param[in] pattern 路由
+     * @param[in] servlet 处理的servlet
+     * @param[in] literal 为true时pattern按原文匹配, 不解析:和*
+     *
+     * @return 是否成功, *不在结尾或同一位置的参数名不一致时失败
+     */
+    bool add(const std::string& pattern, ServletPtr servlet, bool literal = false);
+
+    /**
+     * @brief 添加前缀路由, 等价于按原文添加prefix后接结尾的*
+     */
+    bool addPrefix(const std::string& prefix, ServletPtr servlet);
+
+    /**
+     * @brief 查找路由
+     *
+     * @param[in] path 请求路径
+     * @param[out] params 匹配到的参数, 可为nullptr
+     * @param[out] wildcard 是否由结尾通配符匹配, 可为nullptr
+     *
+     * @return 匹配的servlet, 没有匹配时返回nullptr
+     */
+    ServletPtr match(const std::string& path, Params* params = nullptr, bool* wildcard = nullptr) const;
+
+    size_t size() const {
+        return m_size;
+    }
+  private:
+    struct Node;
+    /**
+     * @brief 沿pattern创建节点
+     *
+     * @return pattern结束处(或*所在处)的节点, pattern非法时返回nullptr
+     */
+    Node* insert(const std::string& pattern, bool literal, bool& is_wildcard, std::string& wildcard_name);
+    bool lookup(const Node* node, const std::string& path, size_t pos
+                , Params* params, bool* wildcard, ServletPtr& out) const;
+  private:
+    std::unique_ptr<Node> m_root;
+    size_t m_size;
+};
+
+}
+}
@@ -1,6 +1,7 @@
 #include "http_server.h"
 #include "http.h"
 #include "../logmanager.h"
+#include "../config.h"
 
 #include <cstring>
 
@@ -9,29 +10,82 @@ namespace http {
 
 static Logger::ptr syslog = FL_SYS_LOG();
 
+static ConfigVar<uint64_t>::ptr g_http_server_keepalive_timeout =
+    Config::Lookup("http_server.keepalive_timeout", (uint64_t)(30 * 1000), "http server keep-alive idle timeout(ms)");
+
+static ConfigVar<uint32_t>::ptr g_http_server_max_requests =
+    Config::Lookup("http_server.max_requests_per_connection", (uint32_t)1000, "http server max requests per connection, 0 for unlimited");
+
 HttpServer::HttpServer(bool keeplive
                        , IOManager* worker
                        , IOManager* accept_worker)
     : TcpServer(worker, accept_worker)
-    , m_isKeeplive(keeplive) {
+    , m_isKeeplive(keeplive)
+    , m_keepaliveTimeout(g_http_server_keepalive_timeout->getVal())
+    , m_maxRequests(g_http_server_max_requests->getVal()) {
     m_dispatch.reset(new ServletDispatch());
 }
 
 void HttpServer::handleClient(Socket::ptr client) {
     http::HttpSession::ptr session(new HttpSession(client));
+    uint32_t count = 0;
     do {
-        auto req = session->recvRequest();
+        if(!session->getPendingSize()) {
+            // 缓冲区中没有流水线请求时连接处于空闲, 优雅停止时可以直接关闭
+            if(!setIdle(client, true)) {
+                break;
+            }
+            // 第一个请求使用普通的读超时, 之后的等待使用keep-alive超时
+            bool ok = session->waitRequest(count ? m_keepaliveTimeout : -1);
+            // 收到请求的第一个字节后就不再空闲, 优雅停止会等它处理完
+            setIdle(client, false);
+            if(!ok) {
+                break;
+            }
+        }
+        auto req = session->recvRequestHeader();
         if(!req) {
-            FL_LOG_WARN(syslog) << "recv http request failed, errno = "
-                                << errno << " error info = " << strerror(errno)
-                                << " client: " << *client;
+            FL_LOG_WARN_RATE(syslog, 10) << "recv http request failed, errno = "
+                                         << errno << " error info = " << strerror(errno)
+                                         << " client: " << *client;
             break;
         }
 
-        HttpResponse::ptr rsp(new HttpResponse(req->getVersion(), req->isClose() || !m_isKeeplive));
-        m_dispatch->handle(req, rsp, session);
+        ++count;
+        bool close = req->isClose() || !m_isKeeplive || isStop()
+                     || (m_maxRequests && count >= m_maxRequests);
+        HttpResponse::ptr rsp = session->newResponse(req->getVersion(), close);
+        auto slt = m_dispatch->route(req);
+        if(slt->getMaxBodySize()) {
+            session->setBodyLimit(slt->getMaxBodySize());
+        }
+        if(session->isBodyTooLarge()
+                || (!slt->isStreamBody() && !session->recvBody(req))) {
+            if(session->isBodyTooLarge()) {
+                // 消息体没有读完, 回复413后关闭连接
+                rsp->setStatus(HttpStatus::PAYLOAD_TOO_LARGE);
+                rsp->setClose(true);
+                session->sendResponse(rsp);
+            }
+            break;
+        }
+        slt->handle(req, rsp, session);
+        if(isStop()) {
+            // 处理期间开始了优雅停止, 完成这个响应后关闭连接
+            rsp->setClose(true);
+        }
 
-        session->sendResponse(rsp);
+        if(session->isResponseStarted()) {
+            // servlet使用了流式响应
+            if(!session->endResponse()) {
+                break;
+            }
+        } else if(session->sendResponse(rsp) <= 0) {
+            break;
+        }
+        if(rsp->isClose() || !session->discardBody()) {
+            break;
+        }
     } while (m_isKeeplive);
     session->close();
 }
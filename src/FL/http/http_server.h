@@ -22,12 +22,30 @@ class HttpServer : public TcpServer {
 		m_dispatch = servd;
 	}
 
+	// keep-alive连接等待下一个请求的超时(毫秒), 超时后关闭连接
+	uint64_t getKeepaliveTimeout() const {
+		return m_keepaliveTimeout;
+	}
+	void setKeepaliveTimeout(uint64_t val) {
+		m_keepaliveTimeout = val;
+	}
+
+	// 每个连接最多处理的请求数, 达到后在最后一个响应中关闭连接, 0表示不限制
+	uint32_t getMaxRequestsPerConnection() const {
+		return m_maxRequests;
+	}
+	void setMaxRequestsPerConnection(uint32_t val) {
+		m_maxRequests = val;
+	}
+
   protected:
     virtual void handleClient(Socket::ptr client) override;
 
   private:
     bool m_isKeeplive;
 	ServletDispatch::ptr m_dispatch;
+	uint64_t m_keepaliveTimeout;
+	uint32_t m_maxRequests;
 };
 
 }
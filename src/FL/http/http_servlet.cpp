@@ -1,6 +1,7 @@
 #include "http_servlet.h"
 #include "resource/rsp_page.hpp"
 
+#include "../epoch.h"
 #include "../logmanager.h"
 
 #include <fnmatch.h>
@@ -8,6 +9,8 @@
 namespace FL {
 namespace http {
 
+static auto syslog = FL_SYS_LOG();
+
 FunctionServlet::FunctionServlet(Callback_t cb)
     : Servlet("FunctionServlet")
     , m_cb(cb) {
@@ -20,15 +23,26 @@ int32_t FunctionServlet::handle(HttpRequest::ptr requeset
     return m_cb(requeset, response, session);
 }
 
+// 只在结尾有一个*的glob, 可以作为前缀放入RadixRouter
+static bool IsPrefixGlob(const std::string& uri) {
+    return !uri.empty() && uri.back() == '*'
+           && uri.find_first_of("*?[\\") == uri.size() - 1;
+}
+
 ServletDispatch::ServletDispatch()
-    : Servlet("ServletDispatch") {
+    : Servlet("ServletDispatch")
+    , m_table(new RouteTable) {
     m_default.reset(new NotFoundServlet);
 }
 
+ServletDispatch::~ServletDispatch() {
+    delete m_table.load(std::memory_order_relaxed);
+}
+
 int32_t ServletDispatch::handle(HttpRequest::ptr requeset
                                 , HttpResponse::ptr response
                                 , HttpSession::ptr session) {
-    auto slt = getMatchServlet(requeset->getPath());
+    auto slt = route(requeset);
     if(slt) {
         slt->handle(requeset, response, session);
     } else {
@@ -37,14 +51,37 @@ int32_t ServletDispatch::handle(HttpRequest::ptr requeset
     return 0;
 }
 
+bool ServletDispatch::rebuild() {
+    RouteTable* table = new RouteTable;
+    for(auto& i : m_routes) {
+        if(!table->router.add(i.first, i.second)) {
+            delete table;
+            return false;
+        }
+    }
+    // 精确路由后添加, 与参数路由重合时精确路由优先
+    for(auto& i : m_datas) {
+        table->router.add(i.first, i.second, true);
+    }
+    for(auto& i : m_globs) {
+        if(IsPrefixGlob(i.first)) {
+            table->router.addPrefix(i.first.substr(0, i.first.size() - 1), i.second);
+        } else {
+            table->globs.push_back(i);
+        }
+    }
+    Epoch::Retire(m_table.exchange(table, std::memory_order_acq_rel));
+    return true;
+}
+
 void ServletDispatch::addServlet(const std::string& uri, Servlet::ptr slt) {
     Mutex_t::WriteLock lock(m_mutex);
     m_datas[uri] = slt;
+    rebuild();
 }
 
 void ServletDispatch::addServlet(const std::string& uri, FunctionServlet::Callback_t cb) {
-    Mutex_t::WriteLock lock(m_mutex);
-    m_datas[uri].reset(new FunctionServlet(cb));
+    addServlet(uri, FunctionServlet::ptr(new FunctionServlet(cb)));
 }
 
 void ServletDispatch::addGlobServlet(const std::string& uri, Servlet::ptr slt) {
@@ -56,15 +93,43 @@ void ServletDispatch::addGlobServlet(const std::string& uri, Servlet::ptr slt) {
         }
     }
     m_globs.push_back(std::make_pair(uri, slt));
+    rebuild();
 }
 
 void ServletDispatch::addGlobServlet(const std::string& uri, FunctionServlet::Callback_t cb) {
     return addGlobServlet(uri, FunctionServlet::ptr(new FunctionServlet(cb)));
 }
 
+bool ServletDispatch::addRoute(const std::string& pattern, Servlet::ptr slt) {
+    Mutex_t::WriteLock lock(m_mutex);
+    std::vector<std::pair<std::string, Servlet::ptr>> old = m_routes;
+    bool found = false;
+    for(auto& i : m_routes) {
+        if(i.first == pattern) {
+            i.second = slt;
+            found = true;
+            break;
+        }
+    }
+    if(!found) {
+        m_routes.push_back(std::make_pair(pattern, slt));
+    }
+    if(!rebuild()) {
+        FL_LOG_ERROR(syslog) << "invalid route pattern: " << pattern;
+        m_routes.swap(old);
+        return false;
+    }
+    return true;
+}
+
+bool ServletDispatch::addRoute(const std::string& pattern, FunctionServlet::Callback_t cb) {
+    return addRoute(pattern, FunctionServlet::ptr(new FunctionServlet(cb)));
+}
+
 void ServletDispatch::delServlet(const std::string& uri) {
     Mutex_t::WriteLock lock(m_mutex);
     m_datas.erase(uri);
+    rebuild();
 }
 
 void ServletDispatch::delGlobServlet(const std::string& uri) {
@@ -75,6 +140,18 @@ void ServletDispatch::delGlobServlet(const std::string& uri) {
             break;
         }
     }
+    rebuild();
+}
+
+void ServletDispatch::delRoute(const std::string& pattern) {
+    Mutex_t::WriteLock lock(m_mutex);
+    for(auto it = m_routes.begin() ; it != m_routes.end() ; ++it) {
+        if(it->first == pattern) {
+            m_routes.erase(it);
+            break;
+        }
+    }
+    rebuild();
 }
 
 Servlet::ptr ServletDispatch::getServlet(const std::string& uri) {
@@ -93,19 +170,38 @@ Servlet::ptr ServletDispatch::getGlobServlet(const std::string& uri) {
     return nullptr;
 }
 
+Servlet::ptr ServletDispatch::route(HttpRequest::ptr req) {
+    RadixRouter::Params params;
+    auto slt = getMatchServlet(req->getPath(), &params);
+    for(auto& i : params) {
+        req->setParam(i.first, i.second);
+    }
+    return slt;
+}
+
 Servlet::ptr ServletDispatch::getMatchServlet(const std::string& uri) {
-    Mutex_t::ReadLock lock(m_mutex);
-    auto it = m_datas.find(uri);
-    if(it != m_datas.end()) {
-        return it->second;
+    return getMatchServlet(uri, nullptr);
+}
+
+Servlet::ptr ServletDispatch::getMatchServlet(const std::string& uri, RadixRouter::Params* params) {
+    Epoch::Guard guard;
+    const RouteTable* table = m_table.load(std::memory_order_acquire);
+    size_t n = params ? params->size() : 0;
+    bool wildcard = false;
+    Servlet::ptr slt = table->router.match(uri, params, &wildcard);
+    if(slt && !wildcard) {
+        return slt;
     }
 
-    for(auto it = m_globs.begin() ; it != m_globs.end() ; ++it) {
-        if(!fnmatch(it->first.c_str(),uri.c_str(),0)) {
-            return it->second;
+    for(auto& i : table->globs) {
+        if(!fnmatch(i.first.c_str(), uri.c_str(), 0)) {
+            if(params) {
+                params->resize(n);
+            }
+            return i.second;
         }
     }
-    return m_default;
+    return slt ? slt : m_default;
 }
 
 NotFoundServlet::NotFoundServlet()
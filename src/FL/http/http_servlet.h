@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <functional>
 #include <string>
@@ -7,6 +8,7 @@
 #include <vector>
 
 #include "http.h"
+#include "http_router.h"
 #include "http_session.h"
 #include "../mutex.h"
 
@@ -26,8 +28,33 @@ class Servlet {
     const std::string& getName() const {
         return m_name;
     }
+
+    /**
+     * @brief 为true时服务器不缓存请求消息体, 由servlet通过HttpSession::readBody
+     *        流式读取; 未读完的部分在handle返回后被丢弃
+     */
+    bool isStreamBody() const {
+        return m_streamBody;
+    }
+    void setStreamBody(bool val) {
+        m_streamBody = val;
+    }
+
+    /**
+     * @brief 请求消息体上限, 0表示使用http.request.max_body_size
+     *
+     * @details 声明的content-length超过上限时直接返回413, 不读取消息体
+     */
+    uint64_t getMaxBodySize() const {
+        return m_maxBodySize;
+    }
+    void setMaxBodySize(uint64_t val) {
+        m_maxBodySize = val;
+    }
   protected:
     std::string m_name;
+    bool m_streamBody = false;
+    uint64_t m_maxBodySize = 0;
 };
 
 class FunctionServlet : public Servlet {
@@ -45,12 +72,21 @@ class FunctionServlet : public Servlet {
     Callback_t m_cb;
 };
 
+/**
+ * @brief 按请求路径分发到servlet
+ *
+ * @details 精确路由、参数路由(addRoute)和以"*"结尾的前缀glob(如"/prefix/" + "*")保存在
+ *          RadixRouter中; 其它glob按添加顺序用fnmatch匹配.
+ *          匹配优先级: 精确/参数路由 > 其它glob > 前缀通配(最长前缀优先) > 默认servlet.
+ *          每次修改重建一份只读路由表并原子替换, 查找过程不加锁
+ */
 class ServletDispatch : public Servlet {
   public:
     typedef std::shared_ptr<ServletDispatch> ptr;
     typedef RWMutex Mutex_t;
 
     ServletDispatch();
+    ~ServletDispatch();
     virtual int32_t handle(HttpRequest::ptr requeset
                            , HttpResponse::ptr response
                            , HttpSession::ptr session) override;
@@ -60,8 +96,20 @@ class ServletDispatch : public Servlet {
     void addGlobServlet(const std::string& uri, Servlet::ptr slt);
     void addGlobServlet(const std::string& uri, FunctionServlet::Callback_t cb);
 
+    /**
+     * @brief 添加参数路由
+     *
+     * @param[in] pattern 如"/user/:id/posts", 结尾可以是*或*name;
+     *                    匹配到的参数可通过HttpRequest::getParam获取
+     *
+     * @return pattern是否合法
+     */
+    bool addRoute(const std::string& pattern, Servlet::ptr slt);
+    bool addRoute(const std::string& pattern, FunctionServlet::Callback_t cb);
+
     void delServlet(const std::string& uri);
     void delGlobServlet(const std::string& uri);
+    void delRoute(const std::string& pattern);
 
     Servlet::ptr getDefault() const {
         return m_default;
@@ -74,10 +122,35 @@ class ServletDispatch : public Servlet {
     Servlet::ptr getGlobServlet(const std::string& uri);
 
     Servlet::ptr getMatchServlet(const std::string& uri);
+
+    /**
+     * @brief 按请求路径查找servlet, 并把参数路由匹配到的参数写入req
+     */
+    Servlet::ptr route(HttpRequest::ptr req);
+
+    /**
+     * @brief 查找servlet, 同时输出参数路由匹配到的参数
+     */
+    Servlet::ptr getMatchServlet(const std::string& uri, RadixRouter::Params* params);
+  private:
+    // 只读的路由表快照
+    struct RouteTable {
+        RadixRouter router;
+        std::vector<std::pair<std::string, Servlet::ptr>> globs;   // 不能放入router的glob
+    };
+
+    /**
+     * @brief 重建路由表, 调用时需持有写锁
+     *
+     * @return 参数路由之间冲突时返回false, 不替换当前路由表
+     */
+    bool rebuild();
   private:
     Mutex_t m_mutex;
     std::unordered_map<std::string, Servlet::ptr> m_datas;
     std::vector<std::pair<std::string, Servlet::ptr>> m_globs;
+    std::vector<std::pair<std::string, Servlet::ptr>> m_routes;
+    std::atomic<const RouteTable*> m_table; // 当前路由表, 旧表交给Epoch回收
     Servlet::ptr m_default;
 };
 
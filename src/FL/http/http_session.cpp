@@ -2,79 +2,434 @@
 #include "http11_parser.h"
 #include "httpclient_parser.h"
 #include "http_parser.h"
-#include "../ScopeGuard.hpp"
+#include "../logmanager.h"
+#include "../config.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
 
 namespace FL {
 namespace http {
 
+static auto syslog = FL_SYS_LOG();
+
+static FL::ConfigVar<uint64_t>::ptr g_http_session_arena_size =
+    FL::Config::Lookup("http.session.arena_size", 8 * 1024ul, "http session per-request arena size, 0 to disable");
+
+// 接收缓冲区的初始大小
+static constexpr size_t s_init_buf_size = 1024;
+
 HttpSession::HttpSession(Socket::ptr sock, bool owner)
-    : SocketStream(sock, owner) {
+    : SocketStream(sock, owner)
+    , m_bufLen(0)
+    , m_parser(new HttpRequestParser)
+    , m_bodyMode(BODY_NONE)
+    , m_bodyRemain(0)
+    , m_chunkCrlf(false)
+    , m_bodyRead(0)
+    , m_bodyLimit(0)
+    , m_bodyTooLarge(false)
+    , m_expectContinue(false)
+    , m_rspStarted(false)
+    , m_rspChunked(false)
+    , m_rspEnded(false) {
+    uint64_t arena_size = g_http_session_arena_size->getVal();
+    if(arena_size) {
+        m_arena = std::make_shared<Arena>(arena_size);
+    }
 }
 
-HttpRequest::ptr HttpSession::recvRequest() {
-    HttpRequestParser::ptr parser(new HttpRequestParser);
-    uint64_t buf_size = HttpRequestParser::GetHttpRequestBufferSize();
-    char* buffer = new char[buf_size];
-    ON_SCOPE_EXIT {
-        delete[] buffer;
-    };
-
-    int offset = 0;
-    do {
-        int len = read(buffer + offset, buf_size - offset);
-        if(len <= 0) {
-			close();
-            return nullptr;
+HttpRequest::ptr HttpSession::newRequest() {
+    // 先释放上一个请求, arena没有被其他地方引用时才能整体回收
+    m_parser->reset(nullptr);
+    if(!m_arena) {
+        return std::make_shared<HttpRequest>();
+    }
+    if(m_arena.use_count() == 1) {
+        m_arena->reset();
+    } else {
+        // 上一个请求的对象被servlet继续持有, 由它们的控制块保持旧arena存活
+        m_arena = std::make_shared<Arena>(m_arena->getInitSize());
+    }
+    return m_arena->makeShared<HttpRequest>(0x11, true, m_arena->getResource());
+}
+
+HttpResponse::ptr HttpSession::newResponse(uint8_t version, bool close) {
+    if(!m_arena) {
+        return std::make_shared<HttpResponse>(version, close);
+    }
+    return m_arena->makeShared<HttpResponse>(version, close, m_arena->getResource());
+}
+
+int HttpSession::fillBuffer() {
+    size_t max_size = HttpRequestParser::GetHttpRequestBufferSize();
+    if(m_buf.empty()) {
+        m_buf.resize(std::min(s_init_buf_size, max_size));
+    }
+    if(m_bufLen == m_buf.size()) {
+        if(m_buf.size() >= max_size) {
+            // 请求头或chunk大小行超过上限
+            return -1;
         }
+        m_buf.resize(std::min(m_buf.size() * 2, max_size));
+    }
+    int len = read(&m_buf[m_bufLen], m_buf.size() - m_bufLen);
+    if(len > 0) {
+        m_bufLen += len;
+    }
+    return len;
+}
 
-        len += offset;
-        size_t nparser = parser->execute(buffer, len);
-        if(parser->hasError()) {
-			close();
-            return nullptr;
+bool HttpSession::waitRequest(uint64_t idle_timeout) {
+    if(m_bufLen) {
+        return true;
+    }
+    int rt = 0;
+    if(idle_timeout != (uint64_t)-1) {
+        // keep-alive空闲等待使用单独的超时, 之后恢复原来的读超时(包括没有超时的情况)
+        Socket::ptr sock = getSocket();
+        int64_t read_timeout = sock->getRecvTimeout();
+        sock->setRecvTimeout(idle_timeout);
+        rt = fillBuffer();
+        sock->setRecvTimeout((uint64_t)read_timeout);
+    } else {
+        rt = fillBuffer();
+    }
+    if(rt <= 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+HttpRequest::ptr HttpSession::recvRequestHeader() {
+    m_parser->reset(newRequest());
+    m_bodyMode = BODY_NONE;
+    m_bodyRemain = 0;
+    m_chunkCrlf = false;
+    m_bodyRead = 0;
+    m_bodyLimit = HttpRequestParser::GetHttpResquestMaxBodySize();
+    m_bodyTooLarge = false;
+    m_expectContinue = false;
+    m_rspStarted = false;
+    m_rspChunked = false;
+    m_rspEnded = false;
+
+    // 解析器在数据不完整时会丢掉被截断的字段, 所以等头部完整后再一次解析
+    size_t scanned = 0;
+    while(true) {
+        if(m_bufLen >= 4) {
+            size_t from = scanned > 3 ? scanned - 3 : 0;
+            if(memmem(&m_buf[from], m_bufLen - from, "\r\n\r\n", 4)) {
+                // execute会把未解析的数据移动到缓冲区开头
+                size_t nparser = m_parser->execute(&m_buf[0], m_bufLen);
+                if(m_parser->hasError() || !m_parser->isFinish()) {
+                    close();
+                    return nullptr;
+                }
+                m_bufLen -= nparser;
+                break;
+            }
+            scanned = m_bufLen;
         }
-        offset = len - nparser;
-        if(offset == buf_size) {
-			close();
+        if(fillBuffer() <= 0) {
+            close();
             return nullptr;
         }
+    }
+
+    HttpRequest::ptr req = m_parser->getData();
+    // 同时存在时以transfer-encoding为准
+    const HttpHeaders& headers = req->getHeaders();
+    if(strcasestr(std::string(headers.get("transfer-encoding")).c_str(), "chunked")) {
+        m_bodyMode = BODY_CHUNKED;
+    } else if(!req->checkGetHaderAs<uint64_t>("content-length", m_bodyRemain, 0)
+              && headers.has("content-length")) {
+        // 无法确定消息体边界, 不能继续处理同一连接上的后续请求
+        FL_LOG_WARN(syslog) << "invalid content-length: " << req->getHeader("content-length");
+        close();
+        return nullptr;
+    } else if(m_bodyRemain > 0) {
+        m_bodyMode = BODY_LENGTH;
+    }
+    if(m_bodyMode != BODY_NONE && req->getVersion() >= 0x11
+            && strcasecmp(std::string(headers.get("expect")).c_str(), "100-continue") == 0) {
+        m_expectContinue = true;
+    }
+    return req;
+}
+
+HttpRequest::ptr HttpSession::recvRequest() {
+    HttpRequest::ptr req = recvRequestHeader();
+    if(!req) {
+        return nullptr;
+    }
+    if(!recvBody(req)) {
+        close();
+        return nullptr;
+    }
+    return req;
+}
+
+bool HttpSession::readLine(std::string& line) {
+    while(true) {
+        if(m_bufLen > 0) {
+            const char* pos = (const char*)memchr(&m_buf[0], '\n', m_bufLen);
+            if(pos) {
+                size_t len = pos - &m_buf[0];
+                line.assign(&m_buf[0], len > 0 && m_buf[len - 1] == '\r' ? len - 1 : len);
+                m_bufLen -= len + 1;
+                memmove(&m_buf[0], &m_buf[len + 1], m_bufLen);
+                return true;
+            }
+        }
+        if(fillBuffer() <= 0) {
+            return false;
+        }
+    }
+}
+
+bool HttpSession::readChunkSize() {
+    std::string line;
+    if(m_chunkCrlf) {
+        if(!readLine(line) || !line.empty()) {
+            return false;
+        }
+        m_chunkCrlf = false;
+    }
+    if(!readLine(line)) {
+        return false;
+    }
+
+    // chunk-size [;chunk-ext]
+    uint64_t size = 0;
+    size_t i = 0;
+    for(; i < line.size() && isxdigit((unsigned char)line[i]); ++i) {
+        if(i >= 16) {
+            return false;
+        }
+        char c = line[i];
+        size = size * 16 + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+    if(i == 0 || (i < line.size() && line[i] != ';' && line[i] != ' ' && line[i] != '\t')) {
+        return false;
+    }
+
+    if(size > m_bodyLimit - std::min(m_bodyRead, m_bodyLimit)) {
+        m_bodyTooLarge = true;
+        return false;
+    }
+    if(size == 0) {
+        // 跳过trailer直到空行
+        do {
+            if(!readLine(line)) {
+                return false;
+            }
+        } while(!line.empty());
+        m_bodyMode = BODY_NONE;
+        return true;
+    }
+    m_bodyRemain = size;
+    return true;
+}
+
+static const char s_continue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
+bool HttpSession::sendContinue() {
+    m_expectContinue = false;
+    return writeFixSize(s_continue, sizeof(s_continue) - 1) > 0;
+}
 
-        if(parser->isFinish()) {
-            break;
+int HttpSession::readBody(void* buffer, size_t length) {
+    if(isBodyTooLarge()) {
+        return -1;
+    }
+    if(m_expectContinue && !sendContinue()) {
+        return -1;
+    }
+    if(m_bodyMode == BODY_CHUNKED && m_bodyRemain == 0) {
+        if(!readChunkSize()) {
+            return -1;
         }
-    } while(true);
+    }
+    if(m_bodyMode == BODY_NONE || length == 0) {
+        return 0;
+    }
 
-    int64_t length = parser->getContentLength();
-    if(length > 0) {
-        std::string body;
-        body.resize(length);
+    size_t n = std::min((uint64_t)length, m_bodyRemain);
+    int rt = 0;
+    if(m_bufLen > 0) {
+        rt = std::min(n, m_bufLen);
+        memcpy(buffer, &m_buf[0], rt);
+        m_bufLen -= rt;
+        if(m_bufLen > 0) {
+            memmove(&m_buf[0], &m_buf[rt], m_bufLen);
+        }
+    } else {
+        rt = read(buffer, n);
+        if(rt <= 0) {
+            // 消息体结束前对端关闭也视为出错
+            return -1;
+        }
+    }
 
-        int len = 0;
-        if(length >= offset) {
-            memcpy(&body[0], buffer, offset);
-            body.append(buffer, offset);
+    m_bodyRemain -= rt;
+    m_bodyRead += rt;
+    if(m_bodyRemain == 0) {
+        if(m_bodyMode == BODY_LENGTH) {
+            m_bodyMode = BODY_NONE;
         } else {
-            memcpy(&body[0], buffer, length);
-            body.append(buffer, length);
+            m_chunkCrlf = true;
+        }
+    }
+    return rt;
+}
+
+bool HttpSession::recvBody(HttpRequest::ptr req) {
+    if(isBodyFinished()) {
+        return true;
+    }
+    // 在读取和分配之前检查声明的长度
+    if(isBodyTooLarge()) {
+        FL_LOG_WARN(syslog) << "http request body too large, limit=" << m_bodyLimit;
+        return false;
+    }
+    if(m_expectContinue && !sendContinue()) {
+        return false;
+    }
+    bool chunked = m_bodyMode == BODY_CHUNKED;
+    std::string body;
+    while(!isBodyFinished()) {
+        if(m_bodyMode == BODY_CHUNKED && m_bodyRemain == 0) {
+            if(!readChunkSize()) {
+                if(m_bodyTooLarge) {
+                    FL_LOG_WARN(syslog) << "http request body too large, limit=" << m_bodyLimit;
+                }
+                return false;
+            }
+            continue;
         }
-        length -= offset;
-        if(length > 0) {
-            if(readFixSize(&body[len], length) <= 0) {
-                return nullptr;
+        // 块大小已在readChunkSize中检查, 这里的分配不会超过上限
+        size_t offset = body.size();
+        body.resize(offset + m_bodyRemain);
+        while(offset < body.size()) {
+            int rt = readBody(&body[offset], body.size() - offset);
+            if(rt <= 0) {
+                return false;
             }
+            offset += rt;
+        }
+    }
+    req->setBody(body);
+    if(chunked) {
+        req->delHeader("transfer-encoding");
+    }
+    return true;
+}
+
+bool HttpSession::discardBody() {
+    if(isBodyFinished()) {
+        return true;
+    }
+    if(m_expectContinue || isBodyTooLarge()) {
+        // 客户端还没有发送消息体或消息体过大, 直接关闭连接比读完更省
+        return false;
+    }
+    char buf[4096];
+    while(!isBodyFinished()) {
+        if(readBody(buf, sizeof(buf)) < 0) {
+            return false;
         }
-        parser->getData()->setBody(body);
     }
-    return parser->getData();
+    return true;
 }
 
-int HttpSession::sendResponse(HttpResponse::ptr rsp) {
-    std::stringstream ss;
-    ss << *rsp;
-    std::string data = ss.str();
-    return writeFixSize(data.c_str(), data.size());
+int64_t HttpSession::sendResponse(HttpResponse::ptr rsp) {
+    uint32_t status = (uint32_t)rsp->getStatus();
+    if(!rsp->getContentLength() && status >= 200 && status != 204 && status != 304
+            && !rsp->getHeaders().has("content-length")) {
+        // 空消息体也要声明长度, 否则keep-alive的客户端只能以连接关闭判断消息体结束
+        rsp->setHeader("content-length", "0");
+    }
+    m_sendBuf.clear();
+    rsp->encodeHead(m_sendBuf);
+
+    m_writeIovs.clear();
+    m_writeIovs.push_back({&m_sendBuf[0], m_sendBuf.size()});
+    if(auto file = rsp->getFile()) {
+        int64_t rt = writeFixIovs(m_writeIovs, MSG_MORE);
+        if(rt <= 0 || rsp->getContentLength() == 0) {
+            return rt;
+        }
+        int64_t n = sendFile(file->getFd(), rsp->getFileOffset(), rsp->getContentLength());
+        return n <= 0 ? n : rt + n;
+    }
+    if(auto arr = rsp->getBodyArray()) {
+        arr->getReadBuffers(m_writeIovs);
+    } else if(!rsp->getBody().empty()) {
+        m_writeIovs.push_back({(void*)rsp->getBody().c_str(), rsp->getBody().size()});
+    }
+    return writeFixIovs(m_writeIovs);
 }
 
+int HttpSession::beginResponse(HttpResponse::ptr rsp) {
+    m_rspStarted = true;
+    m_rspEnded = false;
+    m_rspChunked = false;
+    if(!rsp->getHeaders().has("content-length")) {
+        if(rsp->getVersion() >= 0x11) {
+            rsp->setHeader("Transfer-Encoding", "chunked");
+            m_rspChunked = true;
+        } else {
+            rsp->setClose(true);
+        }
+    }
+    m_sendBuf.clear();
+    if(m_expectContinue) {
+        // 流式servlet可能先开始响应再读取消息体, 100 Continue必须在最终响应之前
+        m_sendBuf.append(s_continue, sizeof(s_continue) - 1);
+        m_expectContinue = false;
+    }
+    rsp->encodeHead(m_sendBuf);
+    return writeFixSize(m_sendBuf.c_str(), m_sendBuf.size());
+}
+
+int64_t HttpSession::writeBody(const void* data, size_t length) {
+    if(!m_rspStarted || m_rspEnded) {
+        return -1;
+    }
+    if(length == 0) {
+        return 0;
+    }
+    if(!m_rspChunked) {
+        return writeFixSize(data, length);
+    }
+
+    // 块大小行, 数据和结尾的\r\n一次发出
+    char head[24];
+    int n = snprintf(head, sizeof(head), "%zx\r\n", length);
+    m_writeIovs.clear();
+    m_writeIovs.push_back({head, (size_t)n});
+    m_writeIovs.push_back({(void*)data, length});
+    m_writeIovs.push_back({(void*)"\r\n", 2});
+    int64_t rt = writeFixIovs(m_writeIovs);
+    if(rt < (int64_t)(n + length + 2)) {
+        return rt <= 0 ? rt : -1;
+    }
+    return length;
+}
+
+bool HttpSession::endResponse() {
+    if(!m_rspStarted || m_rspEnded) {
+        return true;
+    }
+    m_rspEnded = true;
+    if(m_rspChunked) {
+        return writeFixSize("0\r\n\r\n", 5) > 0;
+    }
+    return true;
+}
 
 }
 }
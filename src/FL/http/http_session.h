@@ -2,6 +2,9 @@
 
 #include "../socket_stream.h"
 #include "http.h"
+#include "http_parser.h"
+#include "../arena.h"
+#include <vector>
 
 namespace FL {
 
@@ -12,9 +15,167 @@ class HttpSession : public SocketStream {
     typedef std::shared_ptr<HttpSession> ptr;
 
     HttpSession(Socket::ptr sock, bool owner = true);
+
+    /**
+     * @brief 接收一个完整的请求(含消息体)
+     *
+     * @return 请求, 连接关闭或请求非法时返回nullptr并关闭连接
+     *
+     * @details 接收缓冲区和解析器在连接内复用, 超出当前请求的数据(流水线请求)
+     *          保留在缓冲区中, 下一次调用时直接解析. chunked消息体会被解码,
+     *          并去掉transfer-encoding头
+     */
     HttpRequest::ptr recvRequest();
-    int sendResponse(HttpResponse::ptr rsp);
+
+    /**
+     * @brief 等待下一个请求的第一个字节, 缓冲区中已有数据时直接返回
+     *
+     * @param[in] idle_timeout 等待超时(毫秒), 之后恢复套接字原来的读超时.
+     *            -1表示直接使用套接字的读超时
+     *
+     * @return 是否有数据, 连接关闭或超时时返回false并关闭连接
+     *
+     * @details 与recvRequestHeader分开, 调用方可以在收到数据后立即知道连接不再空闲
+     */
+    bool waitRequest(uint64_t idle_timeout = -1);
+
+    /**
+     * @brief 只接收请求行和头部, 消息体之后通过readBody/recvBody读取
+     *
+     * @return 同recvRequest
+     */
+    HttpRequest::ptr recvRequestHeader();
+
+    /**
+     * @brief 流式读取当前请求的消息体, 支持content-length和chunked
+     *
+     * @return >0 读取的字节数, =0 消息体已读完, <0 出错或对端提前关闭
+     *
+     * @details 内存占用不超过接收缓冲区, 缓冲区为空时直接读入buffer
+     */
+    int readBody(void* buffer, size_t length);
+
+    /**
+     * @brief 读取当前请求的全部消息体存入req
+     *
+     * @return 是否成功, 消息体超过上限时返回false且isBodyTooLarge()为true
+     */
+    bool recvBody(HttpRequest::ptr req);
+
+    /**
+     * @brief 丢弃当前请求未读取的消息体, 以便继续处理下一个请求
+     *
+     * @return 是否成功, 客户端仍在等待100 Continue时返回false, 应关闭连接
+     */
+    bool discardBody();
+
+    bool isBodyFinished() const {
+        return m_bodyMode == BODY_NONE;
+    }
+
+    /**
+     * @brief 设置当前请求的消息体上限, recvRequestHeader时重置为http.request.max_body_size
+     */
+    void setBodyLimit(uint64_t val) {
+        m_bodyLimit = val;
+    }
+    uint64_t getBodyLimit() const {
+        return m_bodyLimit;
+    }
+
+    /**
+     * @brief 消息体是否超过上限, content-length在读取前即可判断, chunked在读到超限的块时判断
+     */
+    bool isBodyTooLarge() const {
+        return m_bodyTooLarge
+               || (m_bodyMode == BODY_LENGTH && m_bodyRead + m_bodyRemain > m_bodyLimit);
+    }
+
+    /**
+     * @brief 创建响应对象, 与当前请求一样从连接的arena分配
+     *
+     * @details 请求和响应对象及其头部都在arena中, 下一次recvRequestHeader时整体回收.
+     *          arena大小由http.session.arena_size配置, 为0时使用全局堆
+     */
+    HttpResponse::ptr newResponse(uint8_t version, bool close);
+
+    /**
+     * @brief 发送响应
+     *
+     * @return >0 发送的字节数, =0 对端关闭, <0 出错
+     *
+     * @details 头部编码到复用的缓冲区, 与消息体(string/ByteArray节点)一起
+     *          一次sendmsg发出; 文件消息体在头部之后用sendfile发送
+     */
+    int64_t sendResponse(HttpResponse::ptr rsp);
+
+    /**
+     * @brief 开始流式响应, 发送状态行和头部, 之后用writeBody发送消息体
+     *
+     * @details rsp已设置content-length头时消息体原样发送; 否则HTTP/1.1
+     *          使用chunked编码, HTTP/1.0以关闭连接作为消息体结束
+     *
+     * @return 同sendResponse
+     */
+    int beginResponse(HttpResponse::ptr rsp);
+
+    /**
+     * @brief 发送一段消息体
+     *
+     * @return >0 发送的消息体字节数, <=0 出错
+     */
+    int64_t writeBody(const void* data, size_t length);
+
+    /**
+     * @brief 结束流式响应, chunked编码时发送最后一个块, 重复调用无效果
+     *
+     * @return 是否成功
+     */
+    bool endResponse();
+
+    bool isResponseStarted() const {
+        return m_rspStarted;
+    }
+
+    // 缓冲区中尚未解析的字节数
+    size_t getPendingSize() const {
+        return m_bufLen;
+    }
+  private:
+    enum BodyMode {
+        BODY_NONE,          // 没有消息体或已读完
+        BODY_LENGTH,        // content-length
+        BODY_CHUNKED        // chunked
+    };
+
+    // 回收arena并创建下一个请求对象
+    HttpRequest::ptr newRequest();
+    // 从连接读取更多数据追加到缓冲区
+    int fillBuffer();
+    // 从缓冲区读取一行(不含\r\n)
+    bool readLine(std::string& line);
+    // 读取下一个chunk的大小行, 最后一个chunk时读完trailer
+    bool readChunkSize();
+    // 客户端发送了Expect: 100-continue时, 在第一次读取消息体前发送100 Continue
+    bool sendContinue();
   private:
+    std::vector<char> m_buf;                // 接收缓冲区, 按需扩大到http.request.buffer_size
+    size_t m_bufLen;                        // 缓冲区中未解析的数据长度
+    HttpRequestParser::ptr m_parser;        // 请求解析器
+    std::string m_sendBuf;                  // 响应头部缓冲区
+    Arena::ptr m_arena;                     // 每个请求的对象都从这里分配
+
+    BodyMode m_bodyMode;                    // 当前请求消息体的读取状态
+    uint64_t m_bodyRemain;                  // content-length剩余字节数或当前chunk剩余字节数
+    bool     m_chunkCrlf;                   // 下一个chunk大小行之前是否有上一个chunk的\r\n
+    uint64_t m_bodyRead;                    // 已读取的消息体字节数
+    uint64_t m_bodyLimit;                   // 消息体上限
+    bool     m_bodyTooLarge;                // chunked消息体是否已超过上限
+    bool     m_expectContinue;              // 是否需要发送100 Continue
+
+    bool     m_rspStarted;                  // 是否已开始流式响应
+    bool     m_rspChunked;                  // 流式响应是否使用chunked编码
+    bool     m_rspEnded;                    // 流式响应是否已结束
 };
 }
 
@@ -0,0 +1,316 @@
+#include "static_file_servlet.h"
+#include "../logmanager.h"
+#include "../util.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FL {
+namespace http {
+
+static auto syslog = FL_SYS_LOG();
+
+static const char* GetContentType(const std::string& path) {
+    static const std::unordered_map<std::string, const char*> s_types = {
+        {"html", "text/html"},
+        {"htm", "text/html"},
+        {"css", "text/css"},
+        {"js", "application/javascript"},
+        {"json", "application/json"},
+        {"txt", "text/plain"},
+        {"xml", "text/xml"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"svg", "image/svg+xml"},
+        {"ico", "image/x-icon"},
+        {"webp", "image/webp"},
+        {"wasm", "application/wasm"},
+        {"pdf", "application/pdf"},
+        {"zip", "application/zip"},
+        {"gz", "application/gzip"},
+        {"mp4", "video/mp4"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+    };
+    size_t pos = path.rfind('.');
+    if(pos != std::string::npos && path.find('/', pos) == std::string::npos) {
+        auto it = s_types.find(path.substr(pos + 1));
+        if(it != s_types.end()) {
+            return it->second;
+        }
+    }
+    return "application/octet-stream";
+}
+
+static std::string HttpDate(time_t t) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    char buf[64];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+static bool ParseHttpDate(const std::string& str, time_t& t) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char* end = strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if(!end || *end) {
+        return false;
+    }
+    t = timegm(&tm);
+    return true;
+}
+
+static bool ParseUint64(const std::string& str, uint64_t& val) {
+    if(str.empty() || str.size() > 19) {
+        return false;
+    }
+    val = 0;
+    for(char c : str) {
+        if(c < '0' || c > '9') {
+            return false;
+        }
+        val = val * 10 + (c - '0');
+    }
+    return true;
+}
+
+/**
+ * @brief 解析单区间的Range头
+ *
+ * @return 1 有效区间, 0 忽略Range返回整个文件, -1 区间不可满足
+ */
+static int ParseRange(const std::string& range, uint64_t size, uint64_t& offset, uint64_t& length) {
+    if(strncasecmp(range.c_str(), "bytes=", 6) != 0) {
+        return 0;
+    }
+    std::string spec = range.substr(6);
+    size_t dash = spec.find('-');
+    // 多区间需要multipart/byteranges, 直接返回整个文件
+    if(dash == std::string::npos || spec.find(',') != std::string::npos) {
+        return 0;
+    }
+    std::string first = spec.substr(0, dash);
+    std::string last = spec.substr(dash + 1);
+
+    if(first.empty()) {
+        // bytes=-n 最后n个字节
+        uint64_t n = 0;
+        if(!ParseUint64(last, n)) {
+            return 0;
+        }
+        if(n == 0 || size == 0) {
+            return -1;
+        }
+        n = n < size ? n : size;
+        offset = size - n;
+        length = n;
+        return 1;
+    }
+
+    uint64_t start = 0;
+    uint64_t end = size - 1;
+    if(!ParseUint64(first, start)
+            || (!last.empty() && !ParseUint64(last, end))) {
+        return 0;
+    }
+    if(start >= size) {
+        return -1;
+    }
+    if(end < start) {
+        return 0;
+    }
+    end = end < size - 1 ? end : size - 1;
+    offset = start;
+    length = end - start + 1;
+    return 1;
+}
+
+// 路径中是否有".."段, 文件名中间的".."(如a..b.txt)不算
+static bool HasDotDotSegment(const std::string& path) {
+    size_t pos = 0;
+    while(pos <= path.size()) {
+        size_t end = path.find('/', pos);
+        if(end == std::string::npos) {
+            end = path.size();
+        }
+        if(end - pos == 2 && path[pos] == '.' && path[pos + 1] == '.') {
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+StaticFileServlet::StaticFileServlet(const std::string& root
+                                     , const std::string& prefix
+                                     , size_t max_cache
+                                     , uint64_t check_interval)
+    : Servlet("StaticFileServlet")
+    , m_root(root)
+    , m_prefix(prefix)
+    , m_maxCache(max_cache)
+    , m_checkInterval(check_interval)
+    , m_notFound(new NotFoundServlet) {
+    while(m_root.size() > 1 && m_root.back() == '/') {
+        m_root.pop_back();
+    }
+}
+
+StaticFileServlet::FileEntry::ptr StaticFileServlet::getEntry(const std::string& path) {
+    uint64_t now = UT::GetCurrentMs();
+    FileEntry::ptr old;
+    {
+        Mutex_t::ReadLock lock(m_mutex);
+        auto it = m_cache.find(path);
+        if(it != m_cache.end()) {
+            old = it->second;
+            if(now - old->checkTime < m_checkInterval) {
+                return old;
+            }
+        }
+    }
+
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        if(old) {
+            Mutex_t::WriteLock lock(m_mutex);
+            m_cache.erase(path);
+        }
+        return nullptr;
+    }
+    if(old && old->size == (uint64_t)st.st_size && old->mtime == st.st_mtime
+            && old->dev == st.st_dev && old->ino == st.st_ino) {
+        Mutex_t::WriteLock lock(m_mutex);
+        old->checkTime = now;
+        return old;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        FL_LOG_WARN(syslog) << "open " << path << " failed, errno=" << errno
+                            << " " << strerror(errno);
+        return nullptr;
+    }
+    // 以打开后的fstat为准, 避免stat与open之间文件被替换
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+
+    FileEntry::ptr entry(new FileEntry);
+    entry->file.reset(new HttpFile(fd));
+    entry->size = st.st_size;
+    entry->mtime = st.st_mtime;
+    entry->dev = st.st_dev;
+    entry->ino = st.st_ino;
+    char etag[64];
+    snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)st.st_mtime, (unsigned long)st.st_size);
+    entry->etag = etag;
+    entry->lastModified = HttpDate(st.st_mtime);
+    entry->contentType = GetContentType(path);
+    entry->checkTime = now;
+
+    if(!m_maxCache) {
+        // 不缓存, 文件描述符随响应释放
+        return entry;
+    }
+    Mutex_t::WriteLock lock(m_mutex);
+    if(!old && m_cache.size() >= m_maxCache && !m_cache.empty()) {
+        // 不维护LRU顺序, 缓存满时淘汰任意一项
+        m_cache.erase(m_cache.begin());
+    }
+    m_cache[path] = entry;
+    return entry;
+}
+
+void StaticFileServlet::clearCache() {
+    Mutex_t::WriteLock lock(m_mutex);
+    m_cache.clear();
+}
+
+int32_t StaticFileServlet::handle(HttpRequest::ptr request
+                                  , HttpResponse::ptr response
+                                  , HttpSession::ptr session) {
+    HttpMethod method = request->getMethod();
+    if(method != HttpMethod::GET && method != HttpMethod::HEAD) {
+        response->setStatus(HttpStatus::METHOD_NOT_ALLOWED);
+        response->setHeader("Allow", "GET, HEAD");
+        response->setHeader("content-length", "0");
+        return 0;
+    }
+
+    const std::string& path = request->getPath();
+    if(path.compare(0, m_prefix.size(), m_prefix) != 0
+            || HasDotDotSegment(path)) {
+        return m_notFound->handle(request, response, session);
+    }
+    std::string file = m_root + "/" + path.substr(m_prefix.size());
+    if(file.back() == '/') {
+        file += "index.html";
+    }
+    auto entry = getEntry(file);
+    if(!entry) {
+        return m_notFound->handle(request, response, session);
+    }
+
+    response->setHeader("Content-Type", entry->contentType);
+    response->setHeader("ETag", entry->etag);
+    response->setHeader("Last-Modified", entry->lastModified);
+    response->setHeader("Accept-Ranges", "bytes");
+
+    std::string inm = request->getHeader("If-None-Match");
+    if(!inm.empty()) {
+        if(inm == "*" || inm.find(entry->etag) != std::string::npos) {
+            response->setStatus(HttpStatus::NOT_MODIFIED);
+            return 0;
+        }
+    } else {
+        time_t since = 0;
+        if(ParseHttpDate(request->getHeader("If-Modified-Since"), since)
+                && entry->mtime <= since) {
+            response->setStatus(HttpStatus::NOT_MODIFIED);
+            return 0;
+        }
+    }
+
+    uint64_t offset = 0;
+    uint64_t length = entry->size;
+    std::string range = request->getHeader("Range");
+    if(!range.empty()) {
+        // If-Range不匹配时忽略Range, ETag只做强比较
+        std::string if_range = request->getHeader("If-Range");
+        if(if_range.empty() || if_range == entry->etag || if_range == entry->lastModified) {
+            int rt = ParseRange(range, entry->size, offset, length);
+            if(rt < 0) {
+                response->setStatus(HttpStatus::RANGE_NOT_SATISFIABLE);
+                response->setHeader("Content-Range", "bytes */" + std::to_string(entry->size));
+                response->setHeader("content-length", "0");
+                return 0;
+            }
+            if(rt > 0) {
+                response->setStatus(HttpStatus::PARTIAL_CONTENT);
+                response->setHeader("Content-Range", "bytes " + std::to_string(offset)
+                                    + "-" + std::to_string(offset + length - 1)
+                                    + "/" + std::to_string(entry->size));
+            }
+        }
+    }
+
+    if(method == HttpMethod::HEAD || length == 0) {
+        response->setHeader("content-length", std::to_string(length));
+    } else {
+        response->setFileBody(entry->file, offset, length);
+    }
+    return 0;
+}
+
+}
+}
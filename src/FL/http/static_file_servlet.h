@@ -0,0 +1,70 @@
+#pragma once
+
+#include "http_servlet.h"
+
+#include <sys/types.h>
+#include <time.h>
+
+namespace FL {
+namespace http {
+
+/**
+ * @brief 静态文件Servlet, 文件内容通过sendfile发送, 不经过用户态
+ *
+ * @details 缓存已打开的文件描述符和元数据(大小/修改时间/ETag), 每隔
+ *          check_interval毫秒重新stat一次, 文件变化后重新打开.
+ *          支持GET/HEAD, If-None-Match/If-Modified-Since条件请求,
+ *          以及单区间的Range/If-Range请求
+ */
+class StaticFileServlet : public Servlet {
+  public:
+    typedef std::shared_ptr<StaticFileServlet> ptr;
+    typedef RWMutex Mutex_t;
+
+    /**
+     * @brief 构造函数
+     *
+     * @param[in] root 文件根目录
+     * @param[in] prefix 请求路径前缀, 去掉前缀后拼接到root之后
+     * @param[in] max_cache 最多缓存的文件数, 0表示不缓存
+     * @param[in] check_interval 缓存项重新stat的间隔(毫秒)
+     */
+    StaticFileServlet(const std::string& root
+                      , const std::string& prefix = "/"
+                      , size_t max_cache = 1024
+                      , uint64_t check_interval = 1000);
+
+    virtual int32_t handle(HttpRequest::ptr request
+                           , HttpResponse::ptr response
+                           , HttpSession::ptr session) override;
+
+    void clearCache();
+  private:
+    struct FileEntry {
+        typedef std::shared_ptr<FileEntry> ptr;
+
+        HttpFile::ptr file;         // 打开的文件, 缓存淘汰后由正在发送的响应继续持有
+        uint64_t      size;
+        time_t        mtime;
+        dev_t         dev;
+        ino_t         ino;
+        std::string   etag;
+        std::string   lastModified;
+        const char*   contentType;
+        uint64_t      checkTime;    // 上次stat的时间(毫秒)
+    };
+
+    FileEntry::ptr getEntry(const std::string& path);
+  private:
+    std::string m_root;
+    std::string m_prefix;
+    size_t      m_maxCache;
+    uint64_t    m_checkInterval;
+    Servlet::ptr m_notFound;
+
+    Mutex_t m_mutex;
+    std::unordered_map<std::string, FileEntry::ptr> m_cache;
+};
+
+}
+}
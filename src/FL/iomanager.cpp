@@ -127,7 +127,8 @@ int IOManager::addEvent(int fd, Event event, std::function<void()> cb) {
 
     int op = ctx->m_events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
     epoll_event ep_event;
-    ep_event.events = EPOLLIN | ctx->m_events | event;
+    // 边缘触发且只注册等待的事件: 只等写的fd不会因为可读而反复唤醒epoll_wait
+    ep_event.events = EPOLLET | ctx->m_events | event;
     ep_event.data.ptr = ctx;
 
     int res = epoll_ctl(m_epfd, op, fd, &ep_event);
@@ -174,7 +175,7 @@ bool IOManager::delEvent(int fd, Event event) {
     Event new_events = (Event)(fd_ctx->m_events & ~event);
     int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
     epoll_event ep_event;
-    // 水平触发
+    // 边缘触发
     ep_event.events = EPOLLET | new_events;
     ep_event.data.ptr = fd_ctx;
 
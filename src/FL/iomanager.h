@@ -31,7 +31,7 @@ class IOManager : public Scheduler, public TimerManager {
          * @brief 事件上下文
          */
         struct EventContext {
-            Scheduler* scheduler;			// 待执行的scheduler
+            Scheduler* scheduler = nullptr;	// 待执行的scheduler
             Coroutine::ptr coroutine;		// 事件协程
             std::function<void()> callback; // 事件的回调函数
 
@@ -69,7 +69,7 @@ class IOManager : public Scheduler, public TimerManager {
         EventContext read;					// 读事件
         EventContext write;					// 写事件
         int fd;								// 事件关联的句柄
-        Event m_events;						// 已经注册事件
+        Event m_events = NONE;				// 已经注册事件
         Mutex_t mutex;						// 互斥锁
     };
 
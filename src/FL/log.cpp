@@ -1,5 +1,12 @@
 #include "log.h"
+#include "checksum.h"
+#include "epoch.h"
 #include <functional>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace FL {
 const std::string LogLevel::toString(Level level) {
@@ -248,7 +255,7 @@ void LogFormatter::parse() {
         REGEX,
         PENDING
     };
-    TYPE type;
+    TYPE type = TYPE::PENDING;
     char sym = '\0';
     int start = -1;
     for(int i = 0 ; i < m_pattern.size() ; ++i) {
@@ -378,17 +385,223 @@ std::string FileLogAppender::configString() {
     return ss.str();
 }
 
+static const char s_ring_magic[8] = {'F', 'L', 'R', 'I', 'N', 'G', '0', '2'};
+static const uint32_t s_ring_record_magic = 0x464C5247;
+
+struct MmapRingLogAppender::Header {
+    char magic[8];                  // 文件标识
+    uint64_t capacity;              // 缓冲区大小
+    std::atomic<uint64_t> head;     // 写指针(逻辑偏移,只增不减)
+    char reserved[40];
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "atomic<uint64_t> must be lock free");
+
+/**
+ * @brief 环形缓冲区中每条日志的头部,8字节对齐
+ */
+struct RingRecord {
+    uint32_t magic;   // 提交标志,最后写入
+    uint32_t length;  // 日志长度
+    uint64_t offset;  // 记录所在的逻辑偏移,用于识别被覆盖的旧数据
+    uint32_t crc;     // offset,length和日志内容的CRC32C,识别头部完整但内容被回绕的写者覆盖的记录
+    uint32_t reserved;
+};
+
+static uint32_t RingRecordCrc(uint64_t offset, uint32_t length, const void* msg) {
+    uint32_t crc = Crc32c(0, &offset, sizeof(offset));
+    crc = Crc32c(crc, &length, sizeof(length));
+    return Crc32c(crc, msg, length);
+}
+
+static uint64_t RingAlign(uint64_t len) {
+    return (len + 7) & ~7ull;
+}
+
+MmapRingLogAppender::MmapRingLogAppender(const std::string& filename, uint64_t size)
+    : m_filename(filename) {
+    uint64_t page = sysconf(_SC_PAGESIZE);
+    m_capacity = (size + page - 1) / page * page;
+    if(m_capacity == 0) {
+        m_capacity = page;
+    }
+    size_t map_size = sizeof(Header) + m_capacity;
+
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd < 0) {
+        std::cerr << "[ERROR]" << "MmapRingLogAppender open " << filename
+                  << " failed: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    struct stat st;
+    bool reuse = fstat(fd, &st) == 0 && (size_t)st.st_size == map_size;
+    if(!reuse && ftruncate(fd, map_size)) {
+        std::cerr << "[ERROR]" << "MmapRingLogAppender ftruncate " << filename
+                  << " failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return;
+    }
+
+    void* addr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) {
+        std::cerr << "[ERROR]" << "MmapRingLogAppender mmap " << filename
+                  << " failed: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    m_header = (Header*)addr;
+    // 文件格式一致时沿用之前的写指针,保留上一次进程崩溃前的日志
+    if(!reuse || memcmp(m_header->magic, s_ring_magic, sizeof(s_ring_magic))
+            || m_header->capacity != m_capacity) {
+        memset(addr, 0, sizeof(Header));
+        memcpy(m_header->magic, s_ring_magic, sizeof(s_ring_magic));
+        m_header->capacity = m_capacity;
+        m_header->head.store(0, std::memory_order_relaxed);
+    }
+    m_data = (char*)addr + sizeof(Header);
+}
+
+MmapRingLogAppender::~MmapRingLogAppender() {
+    if(m_header) {
+        munmap(m_header, sizeof(Header) + m_capacity);
+    }
+}
+
+void MmapRingLogAppender::copyIn(uint64_t offset, const void* buf, size_t len) {
+    uint64_t pos = offset % m_capacity;
+    size_t first = std::min<uint64_t>(len, m_capacity - pos);
+    memcpy(m_data + pos, buf, first);
+    if(first < len) {
+        memcpy(m_data, (const char*)buf + first, len - first);
+    }
+}
+
+void MmapRingLogAppender::log(LogLevel::Level level, LogEvent::ptr event) {
+    if(level < m_level || !m_data) {
+        return;
+    }
+    LogFormatter::ptr formatter = getFormatter();
+    if(!formatter) {
+        return;
+    }
+    std::string msg = formatter->format(event);
+    size_t max_len = m_capacity / 4 - sizeof(RingRecord);
+    if(msg.size() > max_len) {
+        msg.resize(max_len);
+    }
+
+    uint64_t total = RingAlign(sizeof(RingRecord) + msg.size());
+    uint64_t offset = m_header->head.fetch_add(total, std::memory_order_relaxed);
+
+    RingRecord record;
+    record.magic = s_ring_record_magic;
+    record.length = msg.size();
+    record.offset = offset;
+    record.crc = RingRecordCrc(offset, record.length, msg.c_str());
+    record.reserved = 0;
+
+    copyIn(offset + sizeof(RingRecord), msg.c_str(), msg.size());
+    std::atomic_thread_fence(std::memory_order_release);
+    copyIn(offset, &record, sizeof(RingRecord));
+}
+
+std::string MmapRingLogAppender::configString() {
+    Mutex_t::Lock lock(m_mutex);
+    std::stringstream ss;
+    YAML::Node node;
+    node["type"] = "MmapRingLogAppender";
+    node["file"] = m_filename;
+    node["size"] = m_capacity;
+    if(m_level != LogLevel::Level::UNKNOW)
+        node["level"] = LogLevel::toString(m_level);
+    if(hasFromatter())
+        node["formatter"] = m_formatter->getPattern();
+
+    ss << node;
+    return ss.str();
+}
+
+bool MmapRingLogAppender::Dump(const std::string& filename, std::ostream& os) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+        std::cerr << "[ERROR]" << "MmapRingLogAppender::Dump open " << filename
+                  << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) || (size_t)st.st_size < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) {
+        return false;
+    }
+
+    const Header* header = (const Header*)addr;
+    uint64_t capacity = header->capacity;
+    if(memcmp(header->magic, s_ring_magic, sizeof(s_ring_magic))
+            || capacity == 0 || sizeof(Header) + capacity != (size_t)st.st_size) {
+        munmap(addr, st.st_size);
+        return false;
+    }
+    const char* data = (const char*)addr + sizeof(Header);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+
+    auto copy_out = [data, capacity](uint64_t offset, void* buf, size_t len) {
+        uint64_t pos = offset % capacity;
+        size_t first = std::min<uint64_t>(len, capacity - pos);
+        memcpy(buf, data + pos, first);
+        if(first < len) {
+            memcpy((char*)buf + first, data, len - first);
+        }
+    };
+
+    // 从最旧的有效位置开始,跳过被覆盖或未写完的记录
+    uint64_t pos = head > capacity ? head - capacity : 0;
+    std::string msg;
+    while(pos + sizeof(RingRecord) <= head) {
+        RingRecord record;
+        copy_out(pos, &record, sizeof(record));
+        uint64_t total = RingAlign(sizeof(RingRecord) + record.length);
+        if(record.magic != s_ring_record_magic || record.offset != pos
+                || total > capacity || pos + total > head) {
+            pos += 8;
+            continue;
+        }
+        msg.resize(record.length);
+        copy_out(pos + sizeof(RingRecord), &msg[0], record.length);
+        if(record.crc != RingRecordCrc(pos, record.length, msg.c_str())) {
+            pos += 8;
+            continue;
+        }
+        os << msg;
+        pos += total;
+    }
+    munmap(addr, st.st_size);
+    return true;
+}
+
 Logger::Logger(std::string name)
     : m_name(name)
-    , m_level(LogLevel::Level()) {
+    , m_level(LogLevel::Level())
+    , m_appenders(new Appenders_t) {
     m_formatter.reset(new LogFormatter("[%d{%Y-%m-%d %H:%M:%S}]%T%t%T%N%T%F%T[%p]%T[%c]%T[%f:%l:%w]%T%m%n"));
 }
 
+Logger::~Logger() {
+    delete m_appenders.load(std::memory_order_relaxed);
+}
+
 void Logger::log(LogLevel::Level level, LogEvent::ptr event) {
-    if(level >= m_level) {
-        Mutex_t::Lock lock(m_mutex);
-        if(!m_appenders.empty())
-            for(auto& appender : m_appenders)
+    if(isEnabled(level)) {
+        Epoch::Guard guard;
+        const Appenders_t* appenders = getAppenders();
+        if(!appenders->empty())
+            for(auto& appender : *appenders)
                 appender->log(level, event);
         else if(m_root != nullptr)
             m_root->log(level, event);
@@ -426,25 +639,51 @@ void Logger::addAppender(LogAppender::ptr appender) {
     if(!appender->getFormatter()) {
         appender->setFormatter(m_formatter);
     }
-    m_appenders.push_front(appender);
+    Appenders_t* appenders = new Appenders_t(*m_appenders.load(std::memory_order_relaxed));
+    appenders->push_back(appender);
+    const Appenders_t* old = m_appenders.exchange(appenders, std::memory_order_acq_rel);
+    lock.unlock();
+    Epoch::Retire(old);
 }
 
 void Logger::delAppender(LogAppender::ptr appender) {
     Mutex_t::Lock lock(m_mutex);
-    m_appenders.remove(appender);
+    Appenders_t* appenders = new Appenders_t(*m_appenders.load(std::memory_order_relaxed));
+    for(auto it = appenders->begin() ; it != appenders->end() ; ++it) {
+        if(*it == appender) {
+            appenders->erase(it);
+            break;
+        }
+    }
+    const Appenders_t* old = m_appenders.exchange(appenders, std::memory_order_acq_rel);
+    lock.unlock();
+    Epoch::Retire(old);
+}
+
+void Logger::setAppenders(const Appenders_t& appenders) {
+    Mutex_t::Lock lock(m_mutex);
+    for(auto& appender : appenders) {
+        if(!appender->getFormatter()) {
+            appender->setFormatter(m_formatter);
+        }
+    }
+    const Appenders_t* old = m_appenders.exchange(new Appenders_t(appenders), std::memory_order_acq_rel);
+    lock.unlock();
+    Epoch::Retire(old);
 }
 
 void Logger::clearAppenders() {
-    m_appenders.clear();
+    Mutex_t::Lock lock(m_mutex);
+    const Appenders_t* old = m_appenders.exchange(new Appenders_t, std::memory_order_acq_rel);
+    lock.unlock();
+    Epoch::Retire(old);
 }
 
 void Logger::setFormatter(LogFormatter::ptr formatter) {
     Mutex_t::Lock lock(m_mutex);
     m_formatter = formatter;
 
-    for(auto& appender : m_appenders) {
-        Mutex_t::Lock lock(m_mutex);
-        m_formatter = formatter;
+    for(auto& appender : *m_appenders.load(std::memory_order_relaxed)) {
         if(!appender->hasFromatter()) {
             appender->setFormatter(formatter);
         }
@@ -472,11 +711,11 @@ std::string Logger::configString() {
     std::stringstream ss;
     YAML::Node node;
     node["name"] = m_name;
-    if(m_level != LogLevel::Level::UNKNOW)
-        node["level"] = LogLevel::toString(m_level);
+    if(getLevel() != LogLevel::Level::UNKNOW)
+        node["level"] = LogLevel::toString(getLevel());
     node["formatter"] = m_formatter->getPattern();
 
-    for(auto appender : m_appenders)
+    for(auto& appender : *m_appenders.load(std::memory_order_relaxed))
         node["appenders"].push_back(YAML::Load(appender->configString()));
 
     ss << node;
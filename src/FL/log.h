@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <fstream>
 #include <memory>
 #include <functional>
@@ -8,7 +9,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <forward_list>
+#include <time.h>
 #include <yaml-cpp/yaml.h>
 #include "mutex.h"
 
@@ -275,7 +276,7 @@ class LogFormatter {
   private:
     std::string m_pattern;					// 模式串
     std::vector<FormatItem::ptr>  m_items;	// 格式项
-    bool m_error;							// 错误
+    bool m_error = false;					// 错误
 };
 
 /**
@@ -420,6 +421,86 @@ class FileLogAppender : implement LogAppender {
     uint64_t m_lastTime = 0;   // 最后打开时间
 };
 
+/**
+ * @brief 基于mmap环形缓冲区的日志输出地
+ *
+ * @details 日志写入文件映射的环形缓冲区,只保留最近size字节的日志.
+ *          写入只是内存拷贝,进程崩溃后由内核将映射页写回文件,
+ *          可以用Dump()按顺序取出崩溃前的日志.
+ *          每条日志通过原子递增写指针预留空间,多线程写入无需加锁
+ */
+class MmapRingLogAppender : implement LogAppender {
+  public:
+    typedef std::shared_ptr<MmapRingLogAppender> ptr;
+
+    /**
+     * @brief 构造函数,打开(或创建)环形缓冲区文件
+     *
+     * @param[in] filename 文件名
+     * @param[in] size 缓冲区大小(字节),按页大小向上取整
+     */
+    MmapRingLogAppender(const std::string& filename, uint64_t size = 8 * 1024 * 1024);
+
+    /**
+     * @brief 析构函数,解除映射
+     */
+    ~MmapRingLogAppender();
+
+    /**
+     * @brief 生成日志
+     *
+     * @param[in] level 日志等级
+     * @param[in] event 日志事件
+     */
+    void log(LogLevel::Level level, LogEvent::ptr event) override;
+
+    /**
+     * @brief 获取环形缓冲区日志输出地的配置
+     *
+     * @return 配置文本
+     */
+    virtual std::string configString() override;
+
+    /**
+     * @brief 文件是否映射成功
+     *
+     * @return 是否成功
+     */
+    bool isValid() const {
+        return m_data != nullptr;
+    }
+
+    /**
+     * @brief 按写入顺序输出环形缓冲区文件中完整的日志
+     *
+     * @details 跳过校验和不匹配的记录(未写完或被回绕的写者覆盖)
+     *
+     * @param[in] filename 文件名
+     * @param[in] os 输出流
+     *
+     * @return 是否成功
+     */
+    static bool Dump(const std::string& filename, std::ostream& os);
+
+  private:
+    struct Header;
+
+    /**
+     * @brief 将数据拷贝到环形缓冲区的逻辑偏移处(处理回绕)
+     *
+     * @param[in] offset 逻辑偏移
+     * @param[in] buf 数据
+     * @param[in] len 数据长度
+     */
+    void copyIn(uint64_t offset, const void* buf, size_t len);
+
+  private:
+    std::string m_filename;     // 文件名
+    uint64_t m_capacity = 0;    // 缓冲区大小
+    Header* m_header = nullptr; // 文件头(映射内存)
+    char* m_data = nullptr;     // 缓冲区(映射内存)
+};
+
 /**
  * @brief 日志器
  */
@@ -427,6 +508,7 @@ class Logger {
   public:
     typedef std::shared_ptr<Logger> ptr;
     typedef Spinlock Mutex_t;
+    typedef std::vector<LogAppender::ptr> Appenders_t;
 
     /**
      * @brief 日志器构造函数
@@ -435,6 +517,8 @@ class Logger {
      */
     Logger(std::string name = "root");
 
+    ~Logger();
+
     /**
      * @brief 生成日志
      *
@@ -497,6 +581,24 @@ class Logger {
      */
     void clearAppenders();
 
+    /**
+     * @brief 整体替换日志输出地
+     *
+     * @param[in] appenders 新的日志输出地
+     *
+     * @details 正在输出的日志继续使用旧的快照,替换过程中不会丢失日志
+     */
+    void setAppenders(const Appenders_t& appenders);
+
+    /**
+     * @brief 获取日志输出地的只读快照
+     *
+     * @return 日志输出地, 只在调用方所在的Epoch::Guard内有效
+     */
+    const Appenders_t* getAppenders() const {
+        return m_appenders.load(std::memory_order_acquire);
+    }
+
     /**
      * @brief 获取日志器配置
      *
@@ -510,7 +612,7 @@ class Logger {
      * @return 日志等级
      */
     LogLevel::Level getLevel() const {
-        return m_level;
+        return m_level.load(std::memory_order_relaxed);
     }
 
     /**
@@ -519,7 +621,18 @@ class Logger {
      * @param[in] val 日志等级
      */
     void setLevel(LogLevel::Level level) {
-        m_level = level;
+        m_level.store(level, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 该等级的日志是否需要输出
+     *
+     * @param[in] level 日志等级
+     *
+     * @return 是否输出
+     */
+    bool isEnabled(LogLevel::Level level) const {
+        return level >= m_level.load(std::memory_order_relaxed);
     }
 
     /**
@@ -553,8 +666,8 @@ class Logger {
     }
   private:
     std::string m_name;								// 日志器名
-    LogLevel::Level m_level;						// 日志等级
-    std::forward_list<LogAppender::ptr> m_appenders;// 日志输出地
+    std::atomic<LogLevel::Level> m_level;			// 日志等级
+    std::atomic<const Appenders_t*> m_appenders;	// 日志输出地(只读快照,修改时整体替换,旧快照交给Epoch回收)
     LogFormatter::ptr m_formatter;					// 日志格式器
     Logger::ptr m_root;								// 主日志器
     Mutex_t m_mutex;								// 互斥量
@@ -605,4 +718,90 @@ class LogWrap {
     LogEvent::ptr m_event;   // 日志事件
 };
 
+/**
+ * @brief 日志限流器,每个调用点一个实例,限制每秒最多输出的日志条数
+ */
+class LogRateLimiter {
+  public:
+
+    /**
+     * @brief 判断本次日志是否允许输出
+     *
+     * @param[in] max_per_sec 每秒最多输出的条数
+     * @param[out] suppressed 允许输出时,返回自上次输出以来被丢弃的条数
+     *
+     * @return 是否允许输出
+     */
+    bool allow(uint32_t max_per_sec, uint64_t& suppressed) {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        uint64_t sec = (uint32_t)ts.tv_sec;
+        // 窗口和计数放在同一个原子量中, 换窗口时一次CAS同时清零计数, 不会丢失并发的计数
+        uint64_t state = m_state.load(std::memory_order_relaxed);
+        while(true) {
+            uint64_t next;
+            if((state >> 32) != sec && max_per_sec) {
+                next = sec << 32 | 1;
+            } else if((state >> 32) == sec && (uint32_t)state < max_per_sec) {
+                next = state + 1;
+            } else {
+                m_suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if(m_state.compare_exchange_weak(state, next, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+  private:
+    std::atomic<uint64_t> m_state{0};       // 高32位为当前统计窗口(秒), 低32位为窗口内的日志条数
+    std::atomic<uint64_t> m_suppressed{0};  // 被丢弃的日志条数
+};
+
+/**
+ * @brief 日志采样器,每个调用点一个实例,每N条输出一条
+ */
+class LogSampler {
+  public:
+
+    /**
+     * @brief 判断本次日志是否允许输出
+     *
+     * @param[in] n 采样间隔
+     * @param[out] suppressed 允许输出时,返回自上次输出以来被丢弃的条数
+     *
+     * @return 是否允许输出
+     */
+    bool allow(uint32_t n, uint64_t& suppressed) {
+        uint64_t count = m_count.fetch_add(1, std::memory_order_relaxed);
+        if(n <= 1 || count % n == 0) {
+            suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+  private:
+    std::atomic<uint64_t> m_count{0};       // 日志总条数
+    std::atomic<uint64_t> m_suppressed{0};  // 被丢弃的日志条数
+};
+
+/**
+ * @brief 被丢弃的日志条数,输出到日志内容的开头
+ */
+struct LogSuppressed {
+    uint64_t count;
+};
+
+inline std::ostream& operator << (std::ostream& os, const LogSuppressed& val) {
+    if(val.count) {
+        os << "[suppressed " << val.count << " messages] ";
+    }
+    return os;
+}
+
 }
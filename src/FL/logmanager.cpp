@@ -1,6 +1,7 @@
 #include "logmanager.h"
 #include "config.h"
 #include "log.h"
+#include "epoch.h"
 
 namespace FL {
 
@@ -13,12 +14,15 @@ struct LogAppenderDefine {
     LogLevel::Level level = LogLevel::Level::UNKNOW;
     std::string formatter;
     std::string file;
+    uint64_t size = 0;
 
     void setType(const std::string& str) {
         if(str == "FileLogAppender")
             type = 1;
         else if(str == "StdOutLogAppender")
             type = 2;
+        else if(str == "MmapRingLogAppender")
+            type = 3;
     }
 
     bool levelIsUnkonw() const {
@@ -33,6 +37,10 @@ struct LogAppenderDefine {
         return type == 2;
     }
 
+    bool typeIsRing() const {
+        return type == 3;
+    }
+
     bool fmtEmpty() const {
         return formatter.empty();
     }
@@ -45,7 +53,8 @@ struct LogAppenderDefine {
         return type == oth.type
                && level == oth.level
                && formatter == oth.formatter
-               && file == oth.file;
+               && file == oth.file
+               && size == oth.size;
     }
 };
 
@@ -78,7 +87,7 @@ struct LogDefine {
         return name == oth.name
                && level == oth.level
                && formatter == oth.formatter
-               && appenders == appenders;
+               && appenders == oth.appenders;
     }
 
     bool operator < (const LogDefine& oth) const {
@@ -128,7 +137,7 @@ class LexicalCast<std::string, LogDefine> {
                     continue;
                 }
 
-                if(lad.typeIsFile()) {
+                if(lad.typeIsFile() || lad.typeIsRing()) {
                     if(!it["file"].IsDefined()) {
                         FL_LOG_ERROR(FL_SYS_LOG()) << "log config error: fileappender file is empty, " << it;
                         continue;
@@ -136,6 +145,11 @@ class LexicalCast<std::string, LogDefine> {
                     lad.file = it["file"].as<std::string>();
                 }
 
+                if(lad.typeIsRing() && it["size"].IsDefined())
+                    lad.size = it["size"].as<uint64_t>();
+
+                if(it["level"].IsDefined())
+                    lad.level = LogLevel::fromString(it["level"].as<std::string>());
                 if(it["formatter"].IsDefined())
                     lad.formatter = it["formatter"].as<std::string>();
 
@@ -169,6 +183,11 @@ class LexicalCast<LogDefine, std::string> {
                 node_a["file"] = lad.file;
             } else if(lad.typeIsStdout()) {
                 node_a["type"] = "StdOutLogAppender";
+            } else if(lad.typeIsRing()) {
+                node_a["type"] = "MmapRingLogAppender";
+                node_a["file"] = lad.file;
+                if(lad.size)
+                    node_a["size"] = lad.size;
             }
 
             if(!lad.levelIsUnkonw())
@@ -201,20 +220,19 @@ struct LogIniter {
                 auto it = old_val.find(logdef);
                 Logger::ptr logger;
                 if(it == old_val.end())
-                    logger = FL_LOG_NAME(logdef.name);
+                    logger = LogManager::GetInstance()->getLogger(logdef.name);
                 else {
                     if(!(logdef == *it))
-                        logger = FL_LOG_NAME(logdef.name);
+                        logger = LogManager::GetInstance()->getLogger(logdef.name);
                     else
                         continue;
                 }
 
-                logger->setLevel(logdef.level);
-
                 if(!logdef.fmtEmpty())
                     logger->setFormatter(logdef.formatter);
 
-                logger->clearAppenders();
+                // 先构造完整的新输出地集合,再整体替换,其他线程的日志不会阻塞或丢失
+                Logger::Appenders_t appenders;
                 for(auto& lad : logdef.appenders) {
                     LogAppender::ptr appender;
                     if(lad.typeIsFile()) {
@@ -224,7 +242,14 @@ struct LogIniter {
                             FL_LOG_ERROR(FL_SYS_LOG()) << "log config error: fileappener file is empty";
                     } else if(lad.typeIsStdout()) {
                         appender = std::make_shared<StdOutLogAppender>();
+                    } else if(lad.typeIsRing()) {
+                        if(lad.size)
+                            appender = std::make_shared<MmapRingLogAppender>(lad.file, lad.size);
+                        else
+                            appender = std::make_shared<MmapRingLogAppender>(lad.file);
                     }
+                    if(!appender)
+                        continue;
                     if(!lad.levelIsUnkonw()) {
                         appender->setLevel(lad.level);
                     }
@@ -238,14 +263,16 @@ struct LogIniter {
                                                        << " appender type=" << lad.type
                                                        << " formatter=" << lad.formatter << " is invalid";
                     }
-                    logger->addAppender(appender);
+                    appenders.push_back(appender);
                 }
+                logger->setAppenders(appenders);
+                logger->setLevel(logdef.level);
             }
 
             for(auto& logdef : old_val) {
                 auto it = new_val.find(logdef);
                 if(it == new_val.end()) {
-                    auto logger = FL_LOG_NAME(logdef.name);
+                    auto logger = LogManager::GetInstance()->getLogger(logdef.name);
                     logger->setLevel(LogLevel::Level());
                     logger->clearAppenders();
                 }
@@ -260,25 +287,48 @@ static LogIniter _log_init;
 LoggerManager::LoggerManager() {
     m_root.reset(new Logger);
     m_root->addAppender(std::make_shared<StdOutLogAppender>());
-    m_loggers[m_root->getName()] = m_root;
+
+    Map_t* loggers = new Map_t;
+    (*loggers)[m_root->getName()] = &m_root;
+    m_loggers.store(loggers, std::memory_order_release);
+}
+
+LoggerManager::~LoggerManager() {
+    delete m_loggers.load(std::memory_order_relaxed);
 }
 
-Logger::ptr LoggerManager::getLogger(const std::string &name) {
+const Logger::ptr& LoggerManager::getLogger(const std::string &name) {
+    {
+        Epoch::Guard guard;
+        const Map_t* loggers = m_loggers.load(std::memory_order_acquire);
+        auto it = loggers->find(name);
+        if(it != loggers->end())
+            return *it->second;
+    }
+
     Mutex_t::Lock lock(m_mutex);
-    auto it = m_loggers.find(name);
-    if(it != m_loggers.end())
-        return it->second;
-    Logger::ptr logger = std::make_shared<Logger>(name);
-    m_loggers[name] = logger;
+    const Map_t* loggers = m_loggers.load(std::memory_order_relaxed);
+    auto it = loggers->find(name);
+    if(it != loggers->end())
+        return *it->second;
+
+    m_owned.push_back(std::make_shared<Logger>(name));
+    const Logger::ptr& logger = m_owned.back();
+    Map_t* new_loggers = new Map_t(*loggers);
+    (*new_loggers)[name] = &logger;
+    m_loggers.store(new_loggers, std::memory_order_release);
+    lock.unlock();
+    Epoch::Retire(loggers);
     return logger;
 }
 
 std::string LoggerManager::configString() {
-    Mutex_t::Lock lock(m_mutex);
+    Epoch::Guard guard;
+    const Map_t* loggers = m_loggers.load(std::memory_order_acquire);
     std::stringstream ss;
     YAML::Node node;
-    for(const auto& it : m_loggers)
-        node.push_back(YAML::Load(it.second->configString()));
+    for(const auto& it : *loggers)
+        node.push_back(YAML::Load((*it.second)->configString()));
     ss << node;
     return ss.str();
 }
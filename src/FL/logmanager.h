@@ -2,13 +2,26 @@
 #include "log.h"
 #include "singleton.h"
 #include "util.h"
-	
+#include <deque>
+
+#define FL_LOG_ACTIVE_DEBUG 1
+#define FL_LOG_ACTIVE_INFO  2
+#define FL_LOG_ACTIVE_WARN  3
+#define FL_LOG_ACTIVE_ERROR 4
+#define FL_LOG_ACTIVE_FATAL 5
+
+// 编译期最低日志等级,低于该等级的日志宏不生成任何代码(由CMake选项FL_LOG_ACTIVE_LEVEL设置)
+#ifndef FL_LOG_ACTIVE_LEVEL
+#define FL_LOG_ACTIVE_LEVEL FL_LOG_ACTIVE_DEBUG
+#endif
+
 #define FL_LOG_LEVEL(logger,level) \
-	if(logger->getLevel() <= level)\
-		FL::LogWrap(logger,FL::LogEvent::ptr(\
-			new FL::LogEvent(level, __FILE__,__func__,__LINE__ ,0\
-				,FL::UT::GetThreadId(), FL::UT::GetCoroutineId(), time(0),FL::UT::GetThreadName(),logger->getName()))\
-				).getStrIO() 
+	if constexpr((int)(level) >= FL_LOG_ACTIVE_LEVEL)\
+		if(const auto& __fl_logger = (logger); __fl_logger->isEnabled(level))\
+			FL::LogWrap(__fl_logger,FL::LogEvent::ptr(\
+				new FL::LogEvent(level, __FILE__,__func__,__LINE__ ,0\
+					,FL::UT::GetThreadId(), FL::UT::GetCoroutineId(), time(0),FL::UT::GetThreadName(),__fl_logger->getName()))\
+					).getStrIO() 
 
 #define FL_LOG_DEBUG(logger) FL_LOG_LEVEL(logger,FL::LogLevel::Level::DEBUG)
 #define FL_LOG_INFO(logger)  FL_LOG_LEVEL(logger,FL::LogLevel::Level::INFO)
@@ -16,9 +29,42 @@
 #define FL_LOG_ERROR(logger) FL_LOG_LEVEL(logger,FL::LogLevel::Level::ERROR)
 #define FL_LOG_FATAL(logger) FL_LOG_LEVEL(logger,FL::LogLevel::Level::FATAL)
 
+// 每个调用点独立的限流/采样状态, limiter为LogRateLimiter或LogSampler
+#define FL_LOG_LEVEL_LIMIT(logger,level,limiter,n) \
+	if constexpr((int)(level) >= FL_LOG_ACTIVE_LEVEL)\
+		if(const auto& __fl_logger = (logger); __fl_logger->isEnabled(level))\
+			if(uint64_t __fl_suppressed = 0; \
+				([]() -> limiter& { static limiter s_limiter; return s_limiter; })().allow(n, __fl_suppressed))\
+				FL::LogWrap(__fl_logger,FL::LogEvent::ptr(\
+					new FL::LogEvent(level, __FILE__,__func__,__LINE__ ,0\
+						,FL::UT::GetThreadId(), FL::UT::GetCoroutineId(), time(0),FL::UT::GetThreadName(),__fl_logger->getName()))\
+						).getStrIO() << FL::LogSuppressed{__fl_suppressed}
+
+// 每秒最多输出n条
+#define FL_LOG_LEVEL_RATE(logger,level,n) FL_LOG_LEVEL_LIMIT(logger,level,FL::LogRateLimiter,n)
+#define FL_LOG_DEBUG_RATE(logger,n) FL_LOG_LEVEL_RATE(logger,FL::LogLevel::Level::DEBUG,n)
+#define FL_LOG_INFO_RATE(logger,n)  FL_LOG_LEVEL_RATE(logger,FL::LogLevel::Level::INFO,n)
+#define FL_LOG_WARN_RATE(logger,n)  FL_LOG_LEVEL_RATE(logger,FL::LogLevel::Level::WARN,n)
+#define FL_LOG_ERROR_RATE(logger,n) FL_LOG_LEVEL_RATE(logger,FL::LogLevel::Level::ERROR,n)
+#define FL_LOG_FATAL_RATE(logger,n) FL_LOG_LEVEL_RATE(logger,FL::LogLevel::Level::FATAL,n)
+
+// 每n条输出1条
+#define FL_LOG_LEVEL_SAMPLE(logger,level,n) FL_LOG_LEVEL_LIMIT(logger,level,FL::LogSampler,n)
+#define FL_LOG_DEBUG_SAMPLE(logger,n) FL_LOG_LEVEL_SAMPLE(logger,FL::LogLevel::Level::DEBUG,n)
+#define FL_LOG_INFO_SAMPLE(logger,n)  FL_LOG_LEVEL_SAMPLE(logger,FL::LogLevel::Level::INFO,n)
+#define FL_LOG_WARN_SAMPLE(logger,n)  FL_LOG_LEVEL_SAMPLE(logger,FL::LogLevel::Level::WARN,n)
+#define FL_LOG_ERROR_SAMPLE(logger,n) FL_LOG_LEVEL_SAMPLE(logger,FL::LogLevel::Level::ERROR,n)
+#define FL_LOG_FATAL_SAMPLE(logger,n) FL_LOG_LEVEL_SAMPLE(logger,FL::LogLevel::Level::FATAL,n)
+
 #define FL_LOG_ROOT() FL::LogManager::GetInstance()->getRoot()
-#define FL_LOG_NAME(name) FL::LogManager::GetInstance()->getLogger(name)
-#define FL_SYS_LOG() FL::LogManager::GetInstance()->getLogger("system")
+
+// 日志器创建后不会销毁, 每个调用点只查找一次; name须在编译期确定(如字符串字面量),
+// 运行时才知道的名字直接调用FL::LogManager::GetInstance()->getLogger(name)
+#define FL_LOG_NAME(name) \
+	([]() -> const FL::Logger::ptr& {\
+		static const FL::Logger::ptr& s_logger = FL::LogManager::GetInstance()->getLogger(name);\
+		return s_logger; })()
+#define FL_SYS_LOG() FL_LOG_NAME("system")
 
 namespace FL {
 
@@ -28,27 +74,33 @@ namespace FL {
 class LoggerManager {
   public:
     typedef Spinlock Mutex_t;
+    typedef std::unordered_map<std::string, const Logger::ptr*> Map_t;
 
     /**
      * @brief 日志管理器构造函数
      */
     LoggerManager();
 
+    ~LoggerManager();
+
     /**
-     * @brief 获取日志器
+     * @brief 获取日志器,不存在则创建
      *
      * @param[in] name 日志器名
      *
-     * @return 日志器
+     * @return 日志器,引用在进程生命周期内有效
+     *
+     * @details 日志器只增不减,每次新增时复制并发布一份新的只读快照,旧快照交给Epoch回收;
+     *          查找已存在的日志器时只原子读取当前快照,不加锁也不修改引用计数
      */
-    Logger::ptr getLogger(const std::string& name);
+    const Logger::ptr& getLogger(const std::string& name);
 
     /**
      * @brief 获取主日志器
      *
      * @return 主日志器
      */
-    Logger::ptr getRoot() const {
+    const Logger::ptr& getRoot() const {
         return m_root;
     }
 
@@ -62,8 +114,9 @@ class LoggerManager {
 
   private:
     Logger::ptr m_root;								// 主日志器
-    std::map<std::string, Logger::ptr> m_loggers;   // 所有日志器
-    Mutex_t		m_mutex;							// 互斥量
+    std::deque<Logger::ptr> m_owned;				// 除主日志器外的所有日志器,尾部插入不移动已有元素
+    std::atomic<const Map_t*> m_loggers;			// 日志器名到m_root或m_owned中元素的索引(只读快照,修改时整体替换)
+    Mutex_t		m_mutex;							// 互斥量(仅写入时使用)
 };
 
 
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "bytearray.h"
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 在结构体内声明参与序列化的字段
+ *
+ * @details 例:
+ *          struct Msg {
+ *              int32_t id;
+ *              std::string name;
+ *              std::vector<double> values;
+ *              FL_SERIALIZE_FIELDS(id, name, values)
+ *          };
+ *          字段按声明顺序编码, 整数和浮点使用定长编码(遵循ByteArray的字节序),
+ *          字符串和容器使用varint长度前缀
+ */
+#define FL_SERIALIZE_FIELDS(...) \
+    auto __fl_fields() { return std::tie(__VA_ARGS__); } \
+    auto __fl_fields() const { return std::tie(__VA_ARGS__); }
+
+namespace FL {
+
+/**
+ * @brief 类型T的编解码器, 需要支持新的类型时特化此模板
+ */
+template<class T, class Enable = void>
+struct Serializer;
+
+namespace detail {
+
+inline size_t VarintSize(uint64_t val) {
+    size_t n = 1;
+    while(val >= 0x80) {
+        val >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+template<class T, class = void>
+struct HasFields : std::false_type {};
+
+template<class T>
+struct HasFields<T, decltype((void)std::declval<T&>().__fl_fields())> : std::true_type {};
+
+}
+
+// 整数/浮点: 定长编码
+template<class T>
+struct Serializer<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+    static size_t Size(const T&) {
+        return sizeof(T);
+    }
+    static void Write(ByteArray& ba, const T& v) {
+        ba.writeFixedArray(&v, 1);
+    }
+    static void Read(ByteArray& ba, T& v) {
+        ba.readFixedArray(&v, 1);
+    }
+};
+
+// 字符串: varint长度 + 内容
+template<>
+struct Serializer<std::string> {
+    static size_t Size(const std::string& v) {
+        return detail::VarintSize(v.size()) + v.size();
+    }
+    static void Write(ByteArray& ba, const std::string& v) {
+        ba.writeStringVint(v);
+    }
+    static void Read(ByteArray& ba, std::string& v) {
+        v = ba.readStringVint();
+    }
+};
+
+// 数组: varint个数 + 元素, 数值数组整体拷贝
+template<class T>
+struct Serializer<std::vector<T> > {
+    static size_t Size(const std::vector<T>& v) {
+        size_t size = detail::VarintSize(v.size());
+        if(std::is_arithmetic<T>::value) {
+            return size + v.size() * sizeof(T);
+        }
+        for(auto& i : v) {
+            size += Serializer<T>::Size(i);
+        }
+        return size;
+    }
+    static void Write(ByteArray& ba, const std::vector<T>& v) {
+        ba.writeUint64(v.size());
+        if constexpr(std::is_arithmetic<T>::value) {
+            ba.writeFixedArray(v.data(), v.size());
+        } else {
+            for(auto& i : v) {
+                Serializer<T>::Write(ba, i);
+            }
+        }
+    }
+    static void Read(ByteArray& ba, std::vector<T>& v) {
+        uint64_t size = ba.readUint64();
+        if(size > ba.getReadSize()) {
+            throw std::out_of_range("not enough len");
+        }
+        v.resize(size);
+        if constexpr(std::is_arithmetic<T>::value) {
+            ba.readFixedArray(v.data(), v.size());
+        } else {
+            for(auto& i : v) {
+                Serializer<T>::Read(ba, i);
+            }
+        }
+    }
+};
+
+// map: varint个数 + 键值对
+template<class K, class V>
+struct Serializer<std::map<K, V> > {
+    static size_t Size(const std::map<K, V>& v) {
+        size_t size = detail::VarintSize(v.size());
+        for(auto& i : v) {
+            size += Serializer<K>::Size(i.first) + Serializer<V>::Size(i.second);
+        }
+        return size;
+    }
+    static void Write(ByteArray& ba, const std::map<K, V>& v) {
+        ba.writeUint64(v.size());
+        for(auto& i : v) {
+            Serializer<K>::Write(ba, i.first);
+            Serializer<V>::Write(ba, i.second);
+        }
+    }
+    static void Read(ByteArray& ba, std::map<K, V>& v) {
+        uint64_t size = ba.readUint64();
+        v.clear();
+        for(uint64_t i = 0; i < size; ++i) {
+            std::pair<K, V> item;
+            Serializer<K>::Read(ba, item.first);
+            Serializer<V>::Read(ba, item.second);
+            v.emplace_hint(v.end(), std::move(item));
+        }
+    }
+};
+
+// 用FL_SERIALIZE_FIELDS声明了字段的结构体: 依次编码各字段
+template<class T>
+struct Serializer<T, typename std::enable_if<detail::HasFields<T>::value>::type> {
+    static size_t Size(const T& v) {
+        return std::apply([](const auto&... f) {
+            return (size_t(0) + ... + Serializer<std::decay_t<decltype(f)> >::Size(f));
+        }, v.__fl_fields());
+    }
+    static void Write(ByteArray& ba, const T& v) {
+        std::apply([&ba](const auto&... f) {
+            (Serializer<std::decay_t<decltype(f)> >::Write(ba, f), ...);
+        }, v.__fl_fields());
+    }
+    static void Read(ByteArray& ba, T& v) {
+        std::apply([&ba](auto&... f) {
+            (Serializer<std::decay_t<decltype(f)> >::Read(ba, f), ...);
+        }, v.__fl_fields());
+    }
+};
+
+/**
+ * @brief 序列化v, 先计算编码长度一次性预留容量
+ *
+ * @return 写入的字节数
+ */
+template<class T>
+size_t Serialize(ByteArray& ba, const T& v) {
+    size_t size = Serializer<T>::Size(v);
+    ba.addCapacity(size);
+    Serializer<T>::Write(ba, v);
+    return size;
+}
+
+/**
+ * @brief 从ba当前位置反序列化v, 数据不足时抛出std::out_of_range
+ */
+template<class T>
+void Deserialize(ByteArray& ba, T& v) {
+    Serializer<T>::Read(ba, v);
+}
+
+}
@@ -17,7 +17,7 @@ class Singleton {
 template <class T, class X = void, int N = 0>
 class SingletonPtr {
   public:
-    static std::shared_ptr<T> GetInstance() {
+    static const std::shared_ptr<T>& GetInstance() {
         static std::shared_ptr<T> ptr = std::make_shared<T>();
         return ptr;
     }
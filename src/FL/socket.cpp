@@ -76,9 +76,14 @@ int64_t Socket::getSendTimeout() {
 }
 
 void Socket::setSendTimeout(uint64_t time) {
+    // 全0的timeval表示不超时
     struct timeval tv {
-        int(time / 1000), int(time % 1000 * 1000)
+        0, 0
     };
+    if(time != (uint64_t)-1) {
+        tv.tv_sec = time / 1000;
+        tv.tv_usec = time % 1000 * 1000;
+    }
     setOption(SOL_SOCKET, SO_SNDTIMEO, tv);
 }
 
@@ -91,9 +96,14 @@ int64_t Socket::getRecvTimeout() {
 }
 
 void Socket::setRecvTimeout(uint64_t time) {
+    // 全0的timeval表示不超时
     struct timeval tv {
-        int(time / 1000), int(time % 1000 * 1000)
+        0, 0
     };
+    if(time != (uint64_t)-1) {
+        tv.tv_sec = time / 1000;
+        tv.tv_usec = time % 1000 * 1000;
+    }
     setOption(SOL_SOCKET, SO_RCVTIMEO, tv);
 }
 
@@ -37,6 +37,7 @@ class Socket : public std::enable_shared_from_this<Socket>, FL::NonCopyable {
     Socket(int family, int type, int protocol = 0);
     virtual ~Socket();
 
+    // 超时时间单位为毫秒, 没有超时时get返回-1, set传入(uint64_t)-1取消超时
     int64_t getSendTimeout();
     void setSendTimeout(uint64_t time);
 
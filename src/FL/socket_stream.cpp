@@ -1,5 +1,7 @@
 #include "socket_stream.h"
-#include <vector>
+#include "hook.h"
+#include <limits.h>
+#include <string.h>
 
 namespace FL {
 
@@ -25,11 +27,13 @@ int SocketStream::read(ByteArray::ptr byte_arr, size_t length) {
     if(!isConnected()) {
         return -1;
     }
-    std::vector<iovec> iovs;
-    if(!byte_arr->getWriteBuffers(iovs, length)) {
+    m_readIovs.clear();
+    if(!byte_arr->getWriteBuffers(m_readIovs, length)) {
         return -1;
     }
-    int result = m_sock->recv(&iovs[0], iovs.size());
+    // 超过IOV_MAX时recvmsg返回EMSGSIZE, 剩余的iovec由readAvailable继续读取
+    size_t cnt = m_readIovs.size() < IOV_MAX ? m_readIovs.size() : IOV_MAX;
+    int result = m_sock->recv(&m_readIovs[0], cnt);
     if(result) {
         byte_arr->setPosition(byte_arr->getPosition() + result);
     }
@@ -47,17 +51,123 @@ int SocketStream::write(ByteArray::ptr byte_arr, size_t length) {
     if(!isConnected()) {
         return -1;
     }
-    std::vector<iovec> iovs;
-    if(!byte_arr->getReadBuffers(iovs, length)) {
+    m_writeIovs.clear();
+    if(!byte_arr->getReadBuffers(m_writeIovs, length)) {
         return -1;
     }
-    int result = m_sock->send(&iovs[0], iovs.size());
+    int result = m_sock->send(&m_writeIovs[0], m_writeIovs.size());
     if(result) {
         byte_arr->setPosition(byte_arr->getPosition() + result);
     }
     return result;
 }
 
+int SocketStream::readAvailable(ByteArray::ptr byte_arr, size_t length) {
+    int result = read(byte_arr, length);
+    if(result <= 0 || (size_t)result == length) {
+        return result;
+    }
+
+    // 预留的节点已在read中分配, 继续读取只需跳过已写入的iovec
+    size_t total = result;
+    size_t idx = 0;
+    size_t n = result;
+    while(n >= m_readIovs[idx].iov_len) {
+        n -= m_readIovs[idx].iov_len;
+        ++idx;
+    }
+    while(total < length) {
+        m_readIovs[idx].iov_base = (char*)m_readIovs[idx].iov_base + n;
+        m_readIovs[idx].iov_len -= n;
+
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &m_readIovs[idx];
+        msg.msg_iovlen = m_readIovs.size() - idx < IOV_MAX ? m_readIovs.size() - idx : IOV_MAX;
+        // 使用原始recvmsg, EAGAIN时直接返回而不是让出协程
+        ssize_t rt = recvmsg_f(m_sock->getSokcet(), &msg, MSG_DONTWAIT);
+        if(rt < 0 && errno == EINTR) {
+            n = 0;
+            continue;
+        }
+        if(rt <= 0) {
+            break;
+        }
+        total += rt;
+        byte_arr->setPosition(byte_arr->getPosition() + rt);
+        n = rt;
+        while(idx < m_readIovs.size() && n >= m_readIovs[idx].iov_len) {
+            n -= m_readIovs[idx].iov_len;
+            ++idx;
+        }
+    }
+    return total;
+}
+
+int64_t SocketStream::writeAll(ByteArray::ptr byte_arr) {
+    if(!isConnected()) {
+        return -1;
+    }
+    m_writeIovs.clear();
+    byte_arr->getReadBuffers(m_writeIovs);
+    int64_t rt = writeFixIovs(m_writeIovs);
+    if(rt > 0) {
+        byte_arr->setPosition(byte_arr->getPosition() + rt);
+    }
+    return rt;
+}
+
+int64_t SocketStream::writeFixIovs(std::vector<iovec>& iovs, int flags) {
+    if(!isConnected()) {
+        return -1;
+    }
+    int64_t total = 0;
+    size_t idx = 0;
+    while(idx < iovs.size()) {
+        if(iovs[idx].iov_len == 0) {
+            ++idx;
+            continue;
+        }
+        size_t cnt = iovs.size() - idx < IOV_MAX ? iovs.size() - idx : IOV_MAX;
+        int rt = m_sock->send(&iovs[idx], cnt, flags);
+        if(rt <= 0) {
+            // 与writeFixSize一致, 没有全部发送就返回错误, 调用方不能把部分发送当成成功
+            return rt;
+        }
+        total += rt;
+        size_t n = rt;
+        while(idx < iovs.size() && n >= iovs[idx].iov_len) {
+            n -= iovs[idx].iov_len;
+            ++idx;
+        }
+        if(n > 0) {
+            iovs[idx].iov_base = (char*)iovs[idx].iov_base + n;
+            iovs[idx].iov_len -= n;
+        }
+    }
+    return total;
+}
+
+int64_t SocketStream::sendFile(int fd, uint64_t offset, uint64_t length) {
+    if(!isConnected()) {
+        return -1;
+    }
+    off_t off = offset;
+    uint64_t total = 0;
+    while(total < length) {
+        ssize_t rt = ::sendfile(m_sock->getSokcet(), fd, &off, length - total);
+        if(rt < 0) {
+            return rt;
+        }
+        if(rt == 0) {
+            // 文件在fstat之后被截断, 已承诺的长度发不完, 只能让调用方关闭连接
+            return -1;
+        }
+        total += rt;
+    }
+    return total;
+}
+
 void SocketStream::close() {
 	if(m_sock) {
 		m_sock->close();
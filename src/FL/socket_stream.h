@@ -2,6 +2,7 @@
 
 #include "stream.h"
 #include "socket.h"
+#include <vector>
 
 namespace FL {
 
@@ -19,6 +20,53 @@ class SocketStream : public Stream {
     virtual int write(ByteArray::ptr byte_arr, size_t length) override;
     virtual void close() override;
 
+    /**
+     * @brief 读取当前可读的全部数据(最多length字节)
+     *
+     * @param[in] byte_arr 写入位置之后预留length字节的节点
+     * @param[in] length 最多读取的字节数
+     *
+     * @return >0 读取的字节数, =0 对端关闭, <0 出错
+     *
+     * @details 第一次读取与read相同(没有数据时让出协程), 之后以非阻塞方式
+     *          继续读取直到EAGAIN或预留空间写满, 减少一次请求内的调度次数
+     */
+    int readAvailable(ByteArray::ptr byte_arr, size_t length);
+
+    /**
+     * @brief 发送byte_arr中全部未读数据
+     *
+     * @param[in] byte_arr 数据, 发送完成后位置移动到末尾
+     *
+     * @return >0 发送的字节数, =0 无数据或对端关闭, <0 出错
+     *
+     * @details 每次sendmsg提交尽可能多的节点, 部分发送时从断点继续
+     */
+    int64_t writeAll(ByteArray::ptr byte_arr);
+
+    /**
+     * @brief 发送iovs描述的全部数据
+     *
+     * @param[in,out] iovs 数据, 部分发送时会被修改
+     * @param[in] flags sendmsg的flags, 后面还有数据时可传MSG_MORE
+     *
+     * @return >0 全部发送时的字节数, =0 无数据或对端关闭, <0 出错(包括只发送了一部分)
+     *
+     * @details 总字节数可能超过2GiB, 返回int64_t
+     */
+    int64_t writeFixIovs(std::vector<iovec>& iovs, int flags = 0);
+
+    /**
+     * @brief 使用sendfile发送文件区间, 数据不经过用户态
+     *
+     * @param[in] fd 文件描述符
+     * @param[in] offset 文件偏移
+     * @param[in] length 发送长度
+     *
+     * @return 全部发送时返回length, 否则返回<=0(包括文件被截断导致发送不足)
+     */
+    int64_t sendFile(int fd, uint64_t offset, uint64_t length);
+
     Socket::ptr getSocket() const {
         return m_sock;
     }
@@ -29,6 +77,8 @@ class SocketStream : public Stream {
   protected:
     Socket::ptr m_sock;
     bool		m_owner;
+    std::vector<iovec> m_readIovs;		// 读用iovec数组,复用避免每次分配
+    std::vector<iovec> m_writeIovs;		// 写用iovec数组
 };
 
 }
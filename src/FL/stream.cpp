@@ -10,7 +10,7 @@ int Stream::readFixSize(void* buffer, size_t length) {
     size_t offset = 0;
     size_t left = length;
     while(left > 0) {
-        size_t len = read((char*)buffer + offset, left);
+        int len = read((char*)buffer + offset, left);
         if(len <= 0) {
             return len;
         }
@@ -26,7 +26,7 @@ int Stream::readFixSize(ByteArray::ptr byte_arr, size_t length) {
     }
     size_t left = length;
     while(left > 0) {
-        size_t len = read(byte_arr, left);
+        int len = read(byte_arr, left);
         if(len <= 0) {
             return len;
         }
@@ -42,7 +42,7 @@ int Stream::writeFixSize(const void* buffer, size_t length) {
     size_t offset = 0;
     size_t left = length;
     while(left > 0) {
-        size_t len = write((const char*)buffer + offset, left);
+        int len = write((const char*)buffer + offset, left);
         if(len <= 0) {
             return len;
         }
@@ -58,7 +58,7 @@ int Stream::writeFixSize(ByteArray::ptr byte_arr, size_t length) {
     }
     size_t left = length;
     while(left > 0) {
-        size_t len = write(byte_arr, left);
+        int len = write(byte_arr, left);
         if(len <= 0) {
             return len;
         }
@@ -0,0 +1,310 @@
+#include "stream_decorator.h"
+#include "logmanager.h"
+#include <string.h>
+
+namespace FL {
+
+static auto syslog = FL_SYS_LOG();
+
+BufferedReadStream::BufferedReadStream(Stream::ptr stream, size_t buf_size, bool owner)
+    : m_stream(stream)
+    , m_buf(buf_size)
+    , m_begin(0)
+    , m_end(0)
+    , m_bufSize(buf_size)
+    , m_owner(owner) {
+}
+
+int BufferedReadStream::fill() {
+    if(m_begin == m_end) {
+        m_begin = m_end = 0;
+    } else if(m_end == m_buf.size()) {
+        if(m_begin > 0) {
+            memmove(&m_buf[0], &m_buf[m_begin], m_end - m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+        } else {
+            m_buf.resize(m_buf.size() * 2);
+        }
+    }
+    int rt = m_stream->read(&m_buf[m_end], m_buf.size() - m_end);
+    if(rt > 0) {
+        m_end += rt;
+    }
+    return rt;
+}
+
+void BufferedReadStream::consume(size_t n) {
+    m_begin += n < available() ? n : available();
+    if(m_begin == m_end) {
+        m_begin = m_end = 0;
+    }
+}
+
+int BufferedReadStream::read(void* buffer, size_t length) {
+    if(available() == 0) {
+        // 大块读取不经过缓冲
+        if(length >= m_bufSize) {
+            return m_stream->read(buffer, length);
+        }
+        int rt = fill();
+        if(rt <= 0) {
+            return rt;
+        }
+    }
+    size_t len = length < available() ? length : available();
+    memcpy(buffer, data(), len);
+    consume(len);
+    return len;
+}
+
+int BufferedReadStream::read(ByteArray::ptr byte_arr, size_t length) {
+    if(available() == 0) {
+        if(length >= m_bufSize) {
+            return m_stream->read(byte_arr, length);
+        }
+        int rt = fill();
+        if(rt <= 0) {
+            return rt;
+        }
+    }
+    size_t len = length < available() ? length : available();
+    byte_arr->write(data(), len);
+    consume(len);
+    return len;
+}
+
+int BufferedReadStream::peek(void* buffer, size_t length) {
+    while(available() < length) {
+        int rt = fill();
+        if(rt < 0) {
+            return rt;
+        }
+        if(rt == 0) {
+            break;
+        }
+    }
+    size_t len = length < available() ? length : available();
+    memcpy(buffer, data(), len);
+    return len;
+}
+
+int BufferedReadStream::readUntil(std::string& out, const std::string& delim, size_t max_size) {
+    size_t scan = 0;
+    while(true) {
+        if(available() >= delim.size()) {
+            const void* pos = memmem(data() + scan, available() - scan, delim.c_str(), delim.size());
+            if(pos) {
+                size_t len = (const char*)pos - data() + delim.size();
+                if(len > max_size) {
+                    return -1;
+                }
+                out.assign(data(), len);
+                consume(len);
+                return len;
+            }
+            // 分隔符可能跨越两次读取, 下次从末尾delim.size() - 1处继续查找
+            scan = available() - delim.size() + 1;
+        }
+        if(available() >= max_size) {
+            return -1;
+        }
+        int rt = fill();
+        if(rt <= 0) {
+            return rt;
+        }
+    }
+}
+
+int BufferedReadStream::readLine(std::string& line, size_t max_size) {
+    int rt = readUntil(line, "\n", max_size);
+    if(rt > 0) {
+        line.resize(line.size() - 1);
+        if(!line.empty() && line.back() == '\r') {
+            line.resize(line.size() - 1);
+        }
+    }
+    return rt;
+}
+
+int BufferedReadStream::write(const void* buffer, size_t length) {
+    return m_stream->write(buffer, length);
+}
+
+int BufferedReadStream::write(ByteArray::ptr byte_arr, size_t length) {
+    return m_stream->write(byte_arr, length);
+}
+
+void BufferedReadStream::close() {
+    if(m_owner && m_stream) {
+        m_stream->close();
+    }
+}
+
+BufferedWriteStream::BufferedWriteStream(Stream::ptr stream, size_t buf_size, bool owner)
+    : m_stream(stream)
+    , m_buf(buf_size)
+    , m_size(0)
+    , m_owner(owner) {
+}
+
+int BufferedWriteStream::read(void* buffer, size_t length) {
+    return m_stream->read(buffer, length);
+}
+
+int BufferedWriteStream::read(ByteArray::ptr byte_arr, size_t length) {
+    return m_stream->read(byte_arr, length);
+}
+
+int BufferedWriteStream::write(const void* buffer, size_t length) {
+    if(length > m_buf.size() - m_size) {
+        if(!flush()) {
+            return -1;
+        }
+        // 大块数据直接发送
+        if(length >= m_buf.size()) {
+            return m_stream->writeFixSize(buffer, length);
+        }
+    }
+    memcpy(&m_buf[m_size], buffer, length);
+    m_size += length;
+    return length;
+}
+
+int BufferedWriteStream::write(ByteArray::ptr byte_arr, size_t length) {
+    length = length < byte_arr->getReadSize() ? length : byte_arr->getReadSize();
+    if(length > m_buf.size() - m_size) {
+        if(!flush()) {
+            return -1;
+        }
+        if(length >= m_buf.size()) {
+            return m_stream->writeFixSize(byte_arr, length);
+        }
+    }
+    byte_arr->read(&m_buf[m_size], length);
+    m_size += length;
+    return length;
+}
+
+bool BufferedWriteStream::flush() {
+    if(m_size == 0) {
+        return true;
+    }
+    int rt = m_stream->writeFixSize(&m_buf[0], m_size);
+    m_size = 0;
+    return rt > 0;
+}
+
+void BufferedWriteStream::close() {
+    flush();
+    if(m_owner && m_stream) {
+        m_stream->close();
+    }
+}
+
+LimitedStream::LimitedStream(Stream::ptr stream, uint64_t limit)
+    : m_stream(stream)
+    , m_remain(limit) {
+}
+
+int LimitedStream::read(void* buffer, size_t length) {
+    if(m_remain == 0) {
+        return 0;
+    }
+    int rt = m_stream->read(buffer, length < m_remain ? length : m_remain);
+    if(rt > 0) {
+        m_remain -= rt;
+    }
+    return rt;
+}
+
+int LimitedStream::read(ByteArray::ptr byte_arr, size_t length) {
+    if(m_remain == 0) {
+        return 0;
+    }
+    int rt = m_stream->read(byte_arr, length < m_remain ? length : m_remain);
+    if(rt > 0) {
+        m_remain -= rt;
+    }
+    return rt;
+}
+
+int LimitedStream::write(const void* buffer, size_t length) {
+    return m_stream->write(buffer, length);
+}
+
+int LimitedStream::write(ByteArray::ptr byte_arr, size_t length) {
+    return m_stream->write(byte_arr, length);
+}
+
+void LimitedStream::close() {
+}
+
+TeeStream::TeeStream(Stream::ptr stream, Stream::ptr mirror, bool owner)
+    : m_stream(stream)
+    , m_mirror(mirror)
+    , m_owner(owner) {
+}
+
+void TeeStream::mirror(const void* buffer, size_t length) {
+    if(m_mirror && m_mirror->writeFixSize(buffer, length) <= 0) {
+        FL_LOG_WARN(syslog) << "TeeStream mirror write failed, mirror disabled";
+        m_mirror = nullptr;
+    }
+}
+
+void TeeStream::mirror(ByteArray::ptr byte_arr, size_t length, size_t position) {
+    if(!m_mirror) {
+        return;
+    }
+    std::vector<iovec> iovs;
+    byte_arr->getReadBuffers(iovs, length, position);
+    for(auto& iov : iovs) {
+        mirror(iov.iov_base, iov.iov_len);
+    }
+}
+
+int TeeStream::read(void* buffer, size_t length) {
+    int rt = m_stream->read(buffer, length);
+    if(rt > 0) {
+        mirror(buffer, rt);
+    }
+    return rt;
+}
+
+int TeeStream::read(ByteArray::ptr byte_arr, size_t length) {
+    int rt = m_stream->read(byte_arr, length);
+    if(rt > 0) {
+        mirror(byte_arr, rt, byte_arr->getPosition() - rt);
+    }
+    return rt;
+}
+
+int TeeStream::write(const void* buffer, size_t length) {
+    int rt = m_stream->write(buffer, length);
+    if(rt > 0) {
+        mirror(buffer, rt);
+    }
+    return rt;
+}
+
+int TeeStream::write(ByteArray::ptr byte_arr, size_t length) {
+    size_t pos = byte_arr->getPosition();
+    int rt = m_stream->write(byte_arr, length);
+    if(rt > 0) {
+        mirror(byte_arr, rt, pos);
+    }
+    return rt;
+}
+
+void TeeStream::close() {
+    if(!m_owner) {
+        return;
+    }
+    m_stream->close();
+    if(m_mirror) {
+        m_mirror->close();
+    }
+}
+
+}
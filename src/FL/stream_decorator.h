@@ -0,0 +1,186 @@
+#pragma once
+
+#include "stream.h"
+#include <string>
+#include <vector>
+
+namespace FL {
+
+/**
+ * @brief 带读缓冲的流, 小块读取合并成一次底层读取
+ *
+ * @details 除read外提供peek/readLine/readUntil, 以及直接访问缓冲区的
+ *          data/available/consume/fill, 供解析器在缓冲区上原地解析
+ */
+class BufferedReadStream : public Stream {
+  public:
+    typedef std::shared_ptr<BufferedReadStream> ptr;
+
+    /**
+     * @brief 构造函数
+     *
+     * @param[in] stream 被包装的流
+     * @param[in] buf_size 缓冲区初始大小
+     * @param[in] owner 关闭时是否关闭被包装的流
+     */
+    BufferedReadStream(Stream::ptr stream, size_t buf_size = 4096, bool owner = true);
+
+    virtual int read(void* buffer, size_t length) override;
+    virtual int read(ByteArray::ptr byte_arr, size_t length) override;
+
+    virtual int write(const void* buffer, size_t length) override;
+    virtual int write(ByteArray::ptr byte_arr, size_t length) override;
+    virtual void close() override;
+
+    /**
+     * @brief 读取但不消耗数据, 缓冲不足length时会读取底层流
+     *
+     * @return 复制的字节数(对端关闭时可能小于length), <0 出错
+     */
+    int peek(void* buffer, size_t length);
+
+    /**
+     * @brief 读取到分隔符为止(包含分隔符)
+     *
+     * @param[out] out 读取的数据
+     * @param[in] delim 分隔符
+     * @param[in] max_size 最多读取的字节数
+     *
+     * @return >0 消耗的字节数, =0 分隔符之前对端关闭, <0 出错或超过max_size
+     */
+    int readUntil(std::string& out, const std::string& delim, size_t max_size = 64 * 1024);
+
+    /**
+     * @brief 读取一行, line中不含行尾的\r\n或\n
+     *
+     * @return 同readUntil
+     */
+    int readLine(std::string& line, size_t max_size = 64 * 1024);
+
+    /**
+     * @brief 再从底层流读取一次追加到缓冲区, 缓冲区满时扩容
+     *
+     * @return >0 读取的字节数, =0 对端关闭, <0 出错
+     */
+    int fill();
+
+    // 缓冲区中未消耗的数据
+    const char* data() const {
+        return &m_buf[m_begin];
+    }
+    size_t available() const {
+        return m_end - m_begin;
+    }
+    // 消耗缓冲区前n个字节
+    void consume(size_t n);
+
+    Stream::ptr getStream() const {
+        return m_stream;
+    }
+  private:
+    Stream::ptr       m_stream;     // 被包装的流
+    std::vector<char> m_buf;        // 缓冲区
+    size_t            m_begin;      // 未消耗数据的起始位置
+    size_t            m_end;        // 未消耗数据的结束位置
+    size_t            m_bufSize;    // 缓冲区初始大小, 不小于此大小的读取直接读底层流
+    bool              m_owner;      // 是否关闭被包装的流
+};
+
+/**
+ * @brief 带写缓冲的流, 小块写入合并后一次发送, 需要显式flush
+ */
+class BufferedWriteStream : public Stream {
+  public:
+    typedef std::shared_ptr<BufferedWriteStream> ptr;
+
+    BufferedWriteStream(Stream::ptr stream, size_t buf_size = 4096, bool owner = true);
+
+    virtual int read(void* buffer, size_t length) override;
+    virtual int read(ByteArray::ptr byte_arr, size_t length) override;
+
+    virtual int write(const void* buffer, size_t length) override;
+    virtual int write(ByteArray::ptr byte_arr, size_t length) override;
+
+    /**
+     * @brief 发送缓冲区中的全部数据
+     *
+     * @return 是否成功
+     */
+    bool flush();
+
+    /**
+     * @brief 先flush, owner为true时关闭被包装的流
+     */
+    virtual void close() override;
+
+    size_t buffered() const {
+        return m_size;
+    }
+    Stream::ptr getStream() const {
+        return m_stream;
+    }
+  private:
+    Stream::ptr       m_stream;     // 被包装的流
+    std::vector<char> m_buf;        // 缓冲区
+    size_t            m_size;       // 缓冲区中的数据长度
+    bool              m_owner;      // 是否关闭被包装的流
+};
+
+/**
+ * @brief 限制读取长度的流, 读够limit字节后返回0, 用于读取定长的消息体
+ *
+ * @details 写入不受限制, 直接写入被包装的流; 关闭时不关闭被包装的流
+ */
+class LimitedStream : public Stream {
+  public:
+    typedef std::shared_ptr<LimitedStream> ptr;
+
+    LimitedStream(Stream::ptr stream, uint64_t limit);
+
+    virtual int read(void* buffer, size_t length) override;
+    virtual int read(ByteArray::ptr byte_arr, size_t length) override;
+
+    virtual int write(const void* buffer, size_t length) override;
+    virtual int write(ByteArray::ptr byte_arr, size_t length) override;
+    virtual void close() override;
+
+    // 剩余可读的字节数
+    uint64_t getRemain() const {
+        return m_remain;
+    }
+  private:
+    Stream::ptr m_stream;   // 被包装的流
+    uint64_t    m_remain;   // 剩余可读的字节数
+};
+
+/**
+ * @brief 镜像流, 读写主流的同时把数据复制一份写入镜像流
+ *
+ * @details 镜像流写入失败不影响主流, 之后不再写入镜像流
+ */
+class TeeStream : public Stream {
+  public:
+    typedef std::shared_ptr<TeeStream> ptr;
+
+    TeeStream(Stream::ptr stream, Stream::ptr mirror, bool owner = true);
+
+    virtual int read(void* buffer, size_t length) override;
+    virtual int read(ByteArray::ptr byte_arr, size_t length) override;
+
+    virtual int write(const void* buffer, size_t length) override;
+    virtual int write(ByteArray::ptr byte_arr, size_t length) override;
+    virtual void close() override;
+
+    bool isMirrorOk() const {
+        return m_mirror != nullptr;
+    }
+  private:
+    void mirror(const void* buffer, size_t length);
+    void mirror(ByteArray::ptr byte_arr, size_t length, size_t position);
+  private:
+    Stream::ptr m_stream;   // 主流
+    Stream::ptr m_mirror;   // 镜像流
+    bool        m_owner;    // 关闭时是否关闭主流和镜像流
+};
+
+}
@@ -1,21 +1,29 @@
 #include "tcp_server.h"
 #include "config.h"
 #include "logmanager.h"
+#include "util.h"
+#include "hook.h"
 #include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
 
 namespace FL {
 
 static	FL::ConfigVar<uint64_t>::ptr g_tcp_serv_read_timeout =
     FL::Config::Lookup("tcp_server.read_timeout", (uint64_t)(60 * 1000 * 2), "tcp server read timeout");
 
+static FL::ConfigVar<uint32_t>::ptr g_tcp_serv_max_connections =
+    FL::Config::Lookup("tcp_server.max_connections", (uint32_t)0, "tcp server max concurrent connections, 0 for unlimited");
+
 static FL::Logger::ptr syslog = FL_SYS_LOG();
 
 TcpServer::TcpServer(IOManager* worker, IOManager* accept_worker)
     : m_worker(worker)
     , m_accept_worker(accept_worker)
     , m_readTimeout(g_tcp_serv_read_timeout->getVal())
+    , m_stop(true)
     , m_name("FL/1.0.0")
-    , m_stop(true) {
+    , m_maxConnections(g_tcp_serv_max_connections->getVal()) {
 
 }
 
@@ -107,20 +115,119 @@ bool TcpServer::stop() {
         }
         m_socks.clear();
     });
+    wakeAcceptors();
+    return true;
+}
+
+bool TcpServer::gracefulStop(uint64_t timeout_ms) {
+    stop();
+    uint64_t deadline = UT::GetCurrentMs() + timeout_ms;
+    while(getConnections() > 0) {
+        if(UT::GetCurrentMs() >= deadline) {
+            FL_LOG_WARN(syslog) << m_name << " graceful stop timeout, force close "
+                                << getConnections() << " connections";
+            closeClients(true);
+            return false;
+        }
+        // 连接可能在检查之后才进入空闲, 每轮都重新关闭一次
+        closeClients(false);
+        usleep(10 * 1000);
+    }
+    return true;
+}
+
+size_t TcpServer::getConnections() {
+    Mutex_t::Lock lock(m_mutex);
+    return m_clients.size();
+}
+
+bool TcpServer::setIdle(const Socket::ptr& client, bool idle) {
+    Mutex_t::Lock lock(m_mutex);
+    if(idle && m_stop) {
+        return false;
+    }
+    auto it = m_clients.find(client);
+    if(it != m_clients.end()) {
+        it->second = idle;
+    }
     return true;
 }
 
+void TcpServer::closeClients(bool force) {
+    Mutex_t::Lock lock(m_mutex);
+    // hook的读写被取消后会重试, 先shutdown使重试的调用立即返回, 不在这里close以免fd被复用
+    for(auto& i : m_clients) {
+        if(force) {
+            ::shutdown(i.first->getSokcet(), SHUT_RDWR);
+            i.first->cancelAll();
+        } else if(i.second) {
+            // 已有数据到达的连接即将开始处理请求, 留给它自己清除空闲标记
+            char c;
+            if(recv_f(i.first->getSokcet(), &c, 1, MSG_PEEK | MSG_DONTWAIT) > 0) {
+                continue;
+            }
+            ::shutdown(i.first->getSokcet(), SHUT_RD);
+            i.first->cancelRead();
+        }
+    }
+}
+
+void TcpServer::runClient(Socket::ptr client) {
+    handleClient(client);
+    {
+        Mutex_t::Lock lock(m_mutex);
+        m_clients.erase(client);
+    }
+    wakeAcceptors();
+}
+
+bool TcpServer::waitConnectionSlot() {
+    while(!m_stop) {
+        {
+            Mutex_t::Lock lock(m_mutex);
+            if(!m_maxConnections || m_clients.size() < m_maxConnections) {
+                return true;
+            }
+            m_acceptWaiters.push_back(std::make_pair(Scheduler::GetThis(), Coroutine::GetThis()));
+        }
+        // 挂起直到有连接结束或服务器停止
+        Coroutine::YieldToSuspend();
+    }
+    return false;
+}
+
+void TcpServer::wakeAcceptors() {
+    std::vector<std::pair<Scheduler*, Coroutine::ptr> > waiters;
+    {
+        Mutex_t::Lock lock(m_mutex);
+        if(m_acceptWaiters.empty()
+                || (!m_stop && m_maxConnections && m_clients.size() >= m_maxConnections)) {
+            return;
+        }
+        waiters.swap(m_acceptWaiters);
+    }
+    for(auto& i : waiters) {
+        i.first->schedule(i.second);
+    }
+}
+
 void TcpServer::handleClient(Socket::ptr client) {
     FL_LOG_INFO(syslog) << "handleClient: " << *client;
 }
 
 void TcpServer::startAccept(Socket::ptr sock) {
-    while(!m_stop) {
+    while(waitConnectionSlot()) {
         Socket::ptr client = sock->accept();
         if(client) {
             client->setRecvTimeout(m_readTimeout);
-            m_worker->schedule(std::bind(&TcpServer::handleClient
+            {
+                Mutex_t::Lock lock(m_mutex);
+                m_clients[client] = false;
+            }
+            m_worker->schedule(std::bind(&TcpServer::runClient
                                          , shared_from_this(), client));
+        } else if(m_stop) {
+            break;
         } else {
             FL_LOG_ERROR(syslog) << "accept errno = " << errno
                                  << " errstr = " << strerror(errno);
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 #include <functional>
+#include <unordered_map>
 #include "iomanager.h"
+#include "mutex.h"
 #include "noncopyable.h"
 #include "socket.h"
 #include "address.h"
@@ -25,6 +28,17 @@ class TcpServer : public std::enable_shared_from_this<TcpServer>, NonCopyable {
     virtual bool start();
     virtual bool stop();
 
+    /**
+     * @brief 优雅停止: 停止accept, 关闭空闲连接, 等待处理中的连接结束
+     *
+     * @param[in] timeout_ms 最长等待时间, 超时后强制关闭剩余连接
+     *
+     * @return 是否在超时前所有连接都已结束
+     *
+     * @details 在协程中调用时以协程方式等待, 不阻塞线程
+     */
+    virtual bool gracefulStop(uint64_t timeout_ms);
+
     uint64_t getReadTimeout() const {
         return m_readTimeout;
     }
@@ -42,17 +56,54 @@ class TcpServer : public std::enable_shared_from_this<TcpServer>, NonCopyable {
         return m_stop;
     }
 
+    /**
+     * @brief 最大并发连接数, 0表示不限制
+     *
+     * @details 达到上限时暂停accept, 新连接留在内核的监听队列中, 直到有连接结束
+     */
+    uint32_t getMaxConnections() const {
+        return m_maxConnections;
+    }
+    void setMaxConnections(uint32_t val) {
+        m_maxConnections = val;
+    }
+    // 当前连接数
+    size_t getConnections();
+
   protected:
     virtual void handleClient(Socket::ptr client);
     virtual void startAccept(Socket::ptr sock);
+
+    /**
+     * @brief 标记连接是否空闲(正在等待下一个请求), 空闲连接在优雅停止时直接关闭
+     *
+     * @return 标记为空闲时, 服务器已停止则返回false, 调用方应结束该连接
+     */
+    bool setIdle(const Socket::ptr& client, bool idle);
+  private:
+    // 连接处理的外层, 维护连接计数
+    void runClient(Socket::ptr client);
+    // 连接数达到上限时挂起当前accept协程, 返回false表示服务器已停止
+    bool waitConnectionSlot();
+    // 唤醒等待连接数下降的accept协程
+    void wakeAcceptors();
+    // 关闭空闲连接的读端, force为true时关闭全部连接的读写
+    void closeClients(bool force);
   private:
+    typedef Mutex Mutex_t;
+
     std::vector<Socket::ptr>	m_socks;
 
     IOManager*	m_worker;
     IOManager*	m_accept_worker;
     uint64_t	m_readTimeout;
-    bool		m_stop;
+    std::atomic<bool> m_stop;
     std::string m_name;
+
+    uint32_t	m_maxConnections;                               // 最大并发连接数
+    Mutex_t		m_mutex;
+    std::unordered_map<Socket::ptr, bool> m_clients;            // 当前连接及是否空闲
+    std::vector<std::pair<Scheduler*, Coroutine::ptr> > m_acceptWaiters;  // 等待连接数下降的accept协程
 };
 
 }
@@ -51,7 +51,7 @@ uint64_t GetCurrentMs() {
 uint64_t GetCurrentUs() {
     timeval tv;
     gettimeofday(&tv, 0);
-    return tv.tv_sec * 1000 * 1000ul + tv.tv_usec / 1000;
+    return tv.tv_sec * 1000 * 1000ul + tv.tv_usec;
 }
 
 }
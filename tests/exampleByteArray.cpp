@@ -35,15 +35,153 @@ void test() {
     XX(int64_t,  100, writeFint64,  readFint64, 1);
     XX(uint64_t, 100, writeFuint64, readFuint64, 1);
 
-//    XX(int32_t,  100, writeInt32,  readInt32, 1);
-//    XX(uint32_t, 100, writeUint32, readUint32, 1);
-//    XX(int64_t,  100, writeInt64,  readInt64, 1);
-//    XX(uint64_t, 100, writeUint64, readUint64, 1);
+    XX(int32_t,  100, writeInt32,  readInt32, 1);
+    XX(uint32_t, 100, writeUint32, readUint32, 1);
+    XX(int64_t,  100, writeInt64,  readInt64, 1);
+    XX(uint64_t, 100, writeUint64, readUint64, 1);
+
+    XX(int32_t,  100, writeInt32,  readInt32, 4096);
+    XX(uint64_t, 100, writeUint64, readUint64, 4096);
 #undef XX
 }
+
+void test_varint() {
+    std::vector<int64_t> vec;
+    for(int i = 0; i < 64; ++i) {
+        vec.push_back((int64_t)1 << i);
+        vec.push_back(-((int64_t)1 << i));
+    }
+    vec.push_back(INT64_MAX);
+    vec.push_back(INT64_MIN);
+
+    // 节点大小7, 快速路径和跨节点路径都会走到
+    FL::ByteArray::ptr ba(new FL::ByteArray(7));
+    ba->writeInt64s(&vec[0], vec.size());
+    ba->writeUint64(UINT64_MAX);
+    ba->setPosition(0);
+    std::vector<int64_t> out(vec.size());
+    ba->readInt64s(&out[0], out.size());
+    FL_ASSERT(out == vec);
+    FL_ASSERT(ba->readUint64() == UINT64_MAX);
+    FL_ASSERT(ba->getReadSize() == 0);
+    FL_LOG_INFO(lg) << "varint bulk size=" << ba->getSize();
+}
+
+void test_fixed_array() {
+    std::vector<double> dvec;
+    std::vector<uint16_t> svec;
+    for(int i = 0; i < 3000; ++i) {
+        dvec.push_back(i * 1.5 - 100);
+        svec.push_back(rand());
+    }
+    for(int little = 0; little < 2; ++little) {
+        FL::ByteArray::ptr ba(new FL::ByteArray(13));
+        ba->setIsLittleEndian(little);
+        ba->writeFixedArray(&dvec[0], dvec.size());
+        ba->writeFixedArray(&svec[0], svec.size());
+        ba->setPosition(0);
+        FL_ASSERT(ba->readDouble() == dvec[0]);
+        ba->setPosition(0);
+        std::vector<double> dout(dvec.size());
+        std::vector<uint16_t> sout(svec.size());
+        ba->readFixedArray(&dout[0], dout.size());
+        ba->readFixedArray(&sout[0], sout.size());
+        FL_ASSERT(dout == dvec && sout == svec);
+        FL_ASSERT(ba->getReadSize() == 0);
+    }
+    FL_LOG_INFO(lg) << "fixed array ok";
+}
+
+void test_file() {
+    FL::ByteArray::ptr ba(new FL::ByteArray(5));
+    for(int i = 0; i < 1000; ++i) {
+        ba->writeInt32(i - 500);
+        ba->writeStringVint("file data");
+    }
+    ba->setPosition(0);
+    FL_ASSERT(ba->writeToFile("/tmp/exampleByteArray.dat"));
+
+    FL::ByteArray::ptr mb(new FL::ByteArray);
+    FL_ASSERT(mb->mmapFromFile("/tmp/exampleByteArray.dat"));
+    FL_ASSERT(mb->toString() == ba->toString());
+    for(int i = 0; i < 1000; ++i) {
+        FL_ASSERT(mb->readInt32() == i - 500);
+        FL_ASSERT(mb->readStringVint() == "file data");
+    }
+
+    // 映射的内存只读, 末尾之后追加的数据写到新节点
+    bool thrown = false;
+    mb->setPosition(0);
+    try {
+        mb->writeFuint8(0);
+    } catch(std::logic_error& e) {
+        thrown = true;
+    }
+    FL_ASSERT(thrown);
+    mb->setPosition(mb->getSize());
+    mb->writeStringWithoutLength("tail");
+    FL_ASSERT(mb->getSize() == ba->getSize() + 4);
+    FL_LOG_INFO(lg) << "mmap file size=" << mb->getSize();
+}
+
+void test_checksum() {
+    FL::ByteArray::ptr ba(new FL::ByteArray(3));
+    ba->writeStringWithoutLength("123456789");
+    ba->setPosition(0);
+    FL_ASSERT(ba->crc32c() == 0xE3069283);
+    FL_ASSERT(ba->toHex() == "313233343536373839");
+    FL_ASSERT(ba->toHexString() == "31 32 33 34 35 36 37 38 39 ");
+
+    FL_ASSERT(FL::ByteArray().xxhash64() == 0xEF46DB3751D8E999ull);
+    std::string text(1000, 'x');
+    for(size_t i = 0; i < text.size(); ++i) {
+        text[i] = i * 7;
+    }
+    // 不同的节点大小结果相同
+    FL::ByteArray::ptr a(new FL::ByteArray(7));
+    FL::ByteArray::ptr b(new FL::ByteArray(4096));
+    a->writeStringWithoutLength(text);
+    b->writeStringWithoutLength(text);
+    a->setPosition(0);
+    b->setPosition(0);
+    FL_ASSERT(a->xxhash64(1) == b->xxhash64(1));
+    FL_ASSERT(a->crc32c() == b->crc32c());
+    FL_ASSERT(a->toHex() == b->toHex());
+    FL_LOG_INFO(lg) << "xxhash64=" << a->xxhash64() << " crc32c=" << a->crc32c();
+}
+
+void test_slice() {
+    FL::ByteArray::ptr ba(new FL::ByteArray(3));
+    ba->writeStringWithoutLength("hello world");
+
+    FL::ByteArray::ptr sl = ba->slice(6, 5);
+    FL_ASSERT(sl->toString() == "world");
+
+    // 写入原ByteArray不影响共享同一块内存的切片
+    ba->setPosition(6);
+    ba->writeStringWithoutLength("WORLD");
+    FL_ASSERT(sl->toString() == "world");
+
+    FL::ByteArray::ptr head(new FL::ByteArray(4));
+    head->writeStringWithoutLength("say: ");
+    head->setPosition(0);
+    ba->setPosition(0);
+    ba->prepend(*head);
+    ba->setPosition(0);
+    ba->append(*sl);
+    sl->writeStringWithoutLength("!");
+    FL_ASSERT(ba->toString() == "say: hello WORLDworld");
+    FL_LOG_INFO(lg) << "slice/append/prepend: " << ba->toString();
+}
+
 int main(int argc, char** argv) {
 	
 	test();
+    test_varint();
+    test_fixed_array();
+    test_file();
+    test_checksum();
+    test_slice();
 
     return 0;
 }
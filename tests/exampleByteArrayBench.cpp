@@ -0,0 +1,191 @@
+#include "../src/FL/bytearray.h"
+#include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+#include "../src/FL/serialize.h"
+#include <chrono>
+
+auto lg = FL_LOG_ROOT();
+
+static uint64_t NowUS() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 模拟一次请求/响应: 序列化若干字段后再反序列化
+void bench_serialize(bool pool, int loops) {
+    FL::ByteArray::SetPoolEnabled(pool);
+    uint64_t sum = 0;
+    uint64_t bytes = 0;
+    uint64_t start = NowUS();
+    for(int i = 0; i < loops; ++i) {
+        FL::ByteArray::ptr ba(new FL::ByteArray(4096));
+        for(int j = 0; j < 256; ++j) {
+            ba->writeFuint32(j);
+            ba->writeFuint64((uint64_t)i * j);
+            ba->writeStringF16("hello bytearray");
+        }
+        bytes += ba->getSize();
+        ba->setPosition(0);
+        for(int j = 0; j < 256; ++j) {
+            sum += ba->readFuint32();
+            sum += ba->readFuint64();
+            sum += ba->readStringF16().size();
+        }
+    }
+    uint64_t used = NowUS() - start;
+    auto stats = FL::ByteArray::GetPoolStats();
+    FL_LOG_INFO(lg) << "serialize pool=" << pool << " loops=" << loops
+                    << " used=" << used << "us"
+                    << " throughput=" << (used ? bytes / used : 0) << "MB/s"
+                    << " hits=" << stats.hits << " misses=" << stats.misses
+                    << " footprint=" << stats.footprint << " peak=" << stats.peak
+                    << " sum=" << sum;
+}
+
+// 逐字节解码, 作为对照
+static uint64_t ReadVarintByByte(FL::ByteArray::ptr ba) {
+    uint64_t result = 0;
+    for(int i = 0 ; i < 64 ; i += 7) {
+        uint8_t b = ba->readFuint8();
+        result |= ((uint64_t)(b & 0x7F)) << i;
+        if(b < 0x80) {
+            break;
+        }
+    }
+    return result;
+}
+
+void bench_varint(int loops) {
+    std::vector<uint64_t> vals(4096);
+    for(size_t i = 0; i < vals.size(); ++i) {
+        vals[i] = (uint64_t)rand() << (i % 33);
+    }
+    std::vector<uint64_t> out(vals.size());
+    FL::ByteArray::ptr ba(new FL::ByteArray(4096));
+
+#define XX(name, write_code, read_code) { \
+        uint64_t wused = 0, rused = 0, sum = 0; \
+        for(int i = 0; i < loops; ++i) { \
+            ba->clear(); \
+            uint64_t start = NowUS(); \
+            write_code; \
+            wused += NowUS() - start; \
+            ba->setPosition(0); \
+            start = NowUS(); \
+            read_code; \
+            rused += NowUS() - start; \
+            sum += out[i % out.size()]; \
+        } \
+        FL_ASSERT(out == vals); \
+        FL_LOG_INFO(lg) << "varint " name " count=" << (uint64_t)loops * vals.size() \
+                        << " write=" << wused << "us read=" << rused << "us sum=" << sum; \
+    }
+
+    XX("bytewise", for(auto& v : vals) { ba->writeUint64(v); }
+                 , for(auto& v : out) { v = ReadVarintByByte(ba); });
+    XX("single", for(auto& v : vals) { ba->writeUint64(v); }
+               , for(auto& v : out) { v = ba->readUint64(); });
+    XX("bulk", ba->writeUint64s(&vals[0], vals.size())
+             , ba->readUint64s(&out[0], out.size()));
+#undef XX
+}
+
+struct Item {
+    uint32_t id;
+    double price;
+    std::string name;
+    FL_SERIALIZE_FIELDS(id, price, name)
+
+    bool operator==(const Item& o) const {
+        return id == o.id && price == o.price && name == o.name;
+    }
+};
+
+struct Order {
+    uint64_t order_id;
+    int32_t user;
+    std::string remark;
+    std::vector<Item> items;
+    std::vector<uint32_t> tags;
+    FL_SERIALIZE_FIELDS(order_id, user, remark, items, tags)
+
+    bool operator==(const Order& o) const {
+        return order_id == o.order_id && user == o.user && remark == o.remark
+               && items == o.items && tags == o.tags;
+    }
+};
+
+// 手写的等价编解码, 作为对照
+static void WriteOrder(FL::ByteArray& ba, const Order& o) {
+    ba.writeFuint64(o.order_id);
+    ba.writeFint32(o.user);
+    ba.writeStringVint(o.remark);
+    ba.writeUint64(o.items.size());
+    for(auto& i : o.items) {
+        ba.writeFuint32(i.id);
+        ba.writeDouble(i.price);
+        ba.writeStringVint(i.name);
+    }
+    ba.writeUint64(o.tags.size());
+    for(auto& i : o.tags) {
+        ba.writeFuint32(i);
+    }
+}
+
+static void ReadOrder(FL::ByteArray& ba, Order& o) {
+    o.order_id = ba.readFuint64();
+    o.user = ba.readFint32();
+    o.remark = ba.readStringVint();
+    o.items.resize(ba.readUint64());
+    for(auto& i : o.items) {
+        i.id = ba.readFuint32();
+        i.price = ba.readDouble();
+        i.name = ba.readStringVint();
+    }
+    o.tags.resize(ba.readUint64());
+    for(auto& i : o.tags) {
+        i = ba.readFuint32();
+    }
+}
+
+void bench_schema(int loops) {
+    Order order;
+    order.order_id = 1234567890123ull;
+    order.user = -42;
+    order.remark = "deliver before noon";
+    for(int i = 0; i < 32; ++i) {
+        order.items.push_back(Item{(uint32_t)i, i * 0.25, "item-" + std::to_string(i)});
+        order.tags.push_back(i * 7);
+    }
+
+#define XX(name, write_code, read_code) { \
+        uint64_t wused = 0, rused = 0; \
+        Order out; \
+        for(int i = 0; i < loops; ++i) { \
+            FL::ByteArray ba(4096); \
+            uint64_t start = NowUS(); \
+            write_code; \
+            wused += NowUS() - start; \
+            ba.setPosition(0); \
+            start = NowUS(); \
+            read_code; \
+            rused += NowUS() - start; \
+        } \
+        FL_ASSERT(out == order); \
+        FL_LOG_INFO(lg) << "schema " name " loops=" << loops \
+                        << " write=" << wused << "us read=" << rused << "us"; \
+    }
+
+    XX("handwritten", WriteOrder(ba, order), ReadOrder(ba, out));
+    XX("generated", FL::Serialize(ba, order), FL::Deserialize(ba, out));
+#undef XX
+}
+
+int main(int argc, char** argv) {
+    int loops = argc > 1 ? atoi(argv[1]) : 20000;
+    bench_serialize(false, loops);
+    bench_serialize(true, loops);
+    bench_varint(loops / 20);
+    bench_schema(loops);
+    return 0;
+}
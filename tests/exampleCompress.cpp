@@ -0,0 +1,98 @@
+#include "../src/FL/compress_stream.h"
+#include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+
+auto lg = FL_LOG_ROOT();
+
+// 基于ByteArray的内存流, 模拟SocketStream
+class MemStream : public FL::Stream {
+  public:
+    typedef std::shared_ptr<MemStream> ptr;
+
+    MemStream()
+        : m_data(new FL::ByteArray(1000))
+        , m_readPos(0) {
+    }
+
+    int read(void* buffer, size_t length) override {
+        size_t len = std::min(length, m_data->getSize() - m_readPos);
+        m_data->read(buffer, len, m_readPos);
+        m_readPos += len;
+        return len;
+    }
+    int read(FL::ByteArray::ptr byte_arr, size_t length) override {
+        std::string buf(std::min(length, m_data->getSize() - m_readPos), 0);
+        int rt = read(&buf[0], buf.size());
+        byte_arr->write(buf.c_str(), rt);
+        return rt;
+    }
+    int write(const void* buffer, size_t length) override {
+        m_data->write(buffer, length);
+        return length;
+    }
+    int write(FL::ByteArray::ptr byte_arr, size_t length) override {
+        std::string buf(length, 0);
+        byte_arr->read(&buf[0], length);
+        return write(buf.c_str(), length);
+    }
+    void close() override {}
+
+    size_t size() const {
+        return m_data->getSize();
+    }
+  private:
+    FL::ByteArray::ptr m_data;
+    size_t m_readPos;
+};
+
+static std::string MakeText(size_t size) {
+    std::string text;
+    while(text.size() < size) {
+        text += "line " + std::to_string(text.size() % 977) + " of some highly repetitive log text\n";
+    }
+    return text;
+}
+
+void test_bytearray() {
+    std::string text = MakeText(1 << 20);
+    for(auto type : {FL::CompressStream::DEFLATE, FL::CompressStream::ZLIB, FL::CompressStream::GZIP}) {
+        FL::ByteArray in(4096), zipped(4096), out(4096);
+        in.writeStringWithoutLength(text);
+        in.setPosition(0);
+        FL_ASSERT(FL::CompressStream::Compress(in, zipped, type));
+        zipped.setPosition(0);
+        FL_ASSERT(FL::CompressStream::Decompress(zipped, out, type));
+        out.setPosition(0);
+        FL_ASSERT(out.toString() == text);
+        FL_LOG_INFO(lg) << "type=" << type << " " << text.size() << " -> " << zipped.getSize();
+    }
+}
+
+void test_stream() {
+    std::string text = MakeText(300000);
+    MemStream::ptr mem(new MemStream);
+    FL::CompressStream::ptr zs(new FL::CompressStream(mem, FL::CompressStream::GZIP
+                                                      , FL::CompressStream::COMPRESS));
+    for(size_t i = 0; i < text.size(); i += 1000) {
+        zs->write(text.c_str() + i, std::min((size_t)1000, text.size() - i));
+        if(i == 150000) {
+            FL_ASSERT(zs->flush());
+        }
+    }
+    zs->close();
+
+    FL::CompressStream::ptr us(new FL::CompressStream(mem, FL::CompressStream::GZIP
+                                                      , FL::CompressStream::DECOMPRESS));
+    FL::ByteArray::ptr out(new FL::ByteArray(4096));
+    while(us->read(out, 3000) > 0) {
+    }
+    out->setPosition(0);
+    FL_ASSERT(out->toString() == text);
+    FL_LOG_INFO(lg) << "stream " << text.size() << " -> " << mem->size();
+}
+
+int main(int argc, char** argv) {
+    test_bytearray();
+    test_stream();
+    return 0;
+}
@@ -1,8 +1,11 @@
 #include "../src/FL/iomanager.h"
 #include "../src/FL/logmanager.h"
 #include "../src/FL/hook.h"
+#include "../src/FL/macro.h"
 #include <string.h>
+#include <time.h>
 #include <arpa/inet.h>
+#include <sys/socket.h>
 
 FL::Logger::ptr g_logger = FL_LOG_ROOT();
 
@@ -59,9 +62,145 @@ void test_sock() {
     FL_LOG_INFO(g_logger) << buff;
 }
 
+static uint64_t CpuTimeMS() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 在协程中建立一对回环tcp连接, 两端都由hook管理
+static void MakePair(int& client, int& server) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr.s_addr);
+    FL_ASSERT(bind(listener, (const sockaddr*)&addr, sizeof(addr)) == 0);
+    FL_ASSERT(listen(listener, 1) == 0);
+    socklen_t len = sizeof(addr);
+    FL_ASSERT(getsockname(listener, (sockaddr*)&addr, &len) == 0);
+
+    client = socket(AF_INET, SOCK_STREAM, 0);
+    FL_ASSERT(connect(client, (const sockaddr*)&addr, sizeof(addr)) == 0);
+    server = accept(listener, nullptr, nullptr);
+    FL_ASSERT(server >= 0);
+    close(listener);
+}
+
+// 不经过hook把fd的发送缓冲区写满, 返回写入的字节数
+static size_t FillSendBuffer(int fd) {
+    static char buf[4096] = {0};
+    size_t total = 0;
+    while(true) {
+        ssize_t n = send_f(fd, buf, sizeof(buf), 0);
+        if(n < 0) {
+            FL_ASSERT(errno == EAGAIN);
+            return total;
+        }
+        total += n;
+    }
+}
+
+// 发送缓冲区满时写操作让出协程, 对端读走数据后被唤醒继续写
+void test_write_block() {
+    static const size_t s_size = 8 * 1024 * 1024;
+    size_t sent = 0;
+    size_t received = 0;
+    bool reader_ran = false;
+    {
+        FL::IOManager iom(1, false, "write_block");
+        iom.schedule([&]() {
+            int client = -1;
+            int server = -1;
+            MakePair(client, server);
+            FL::fd_manager::GetInstance()->get(client)->setTimeout(SO_SNDTIMEO, 5000);
+            FL::fd_manager::GetInstance()->get(server)->setTimeout(SO_RCVTIMEO, 5000);
+
+            // 只有一个线程, 写操作阻塞时不让出协程的话读者永远没有机会运行
+            FL::IOManager::GetThis()->schedule([&, server]() {
+                reader_ran = true;
+                FL_ASSERT(sent < s_size);
+                std::string buf(64 * 1024, '\0');
+                while(received < s_size) {
+                    ssize_t n = recv(server, &buf[0], buf.size(), 0);
+                    FL_ASSERT(n > 0);
+                    received += n;
+                }
+                close(server);
+            });
+
+            std::string data(s_size, 'x');
+            while(sent < s_size) {
+                ssize_t n = send(client, data.c_str() + sent, s_size - sent, 0);
+                FL_ASSERT(n > 0);
+                sent += n;
+            }
+            close(client);
+        });
+    }
+    FL_ASSERT(reader_ran);
+    FL_ASSERT(sent == s_size);
+    FL_ASSERT(received == s_size);
+    FL_LOG_INFO(g_logger) << "test_write_block ok";
+}
+
+// 只注册了写事件的fd在可读不可写时不会被唤醒, 也不会让epoll_wait空转
+void test_write_only_event() {
+    bool woken = false;
+    bool checked = false;
+    {
+        FL::IOManager iom(1, false, "write_only");
+        iom.schedule([&]() {
+            int client = -1;
+            int server = -1;
+            MakePair(client, server);
+            size_t filled = FillSendBuffer(client);
+            // 对端发来数据, client可读但仍不可写
+            FL_ASSERT(send_f(server, "ping", 4, 0) == 4);
+
+            FL::IOManager* iom = FL::IOManager::GetThis();
+            uint64_t cpu_begin = CpuTimeMS();
+            FL_ASSERT(iom->addEvent(client, FL::IOManager::WRITE, [&, client]() {
+                FL_ASSERT(checked);
+                woken = true;
+                close(client);
+            }) == 0);
+
+            iom->addTimer(300, [&, server, filled, cpu_begin]() {
+                FL_ASSERT(!woken);
+                // 水平触发的可读事件会让idle协程在这段时间内一直空转
+                FL_ASSERT(CpuTimeMS() - cpu_begin < 100);
+                checked = true;
+
+                FL::IOManager::GetThis()->schedule([&, server, filled]() {
+                    std::string buf(64 * 1024, '\0');
+                    size_t received = 0;
+                    while(received < filled) {
+                        ssize_t n = recv(server, &buf[0], buf.size(), 0);
+                        FL_ASSERT(n > 0);
+                        received += n;
+                    }
+                    close(server);
+                });
+            });
+        });
+    }
+    FL_ASSERT(woken);
+    FL_LOG_INFO(g_logger) << "test_write_only_event ok";
+}
+
+// 用法: exampleHook          测试hook的读写等待
+//       exampleHook sock     连接外部http服务器
 int main(int argc, char** argv) {
-    //  test_sleep();
-    FL::IOManager iom(1, true, "main");
-    iom.schedule(test_sock);
+    if(argc > 1) {
+        //  test_sleep();
+        FL::IOManager iom(1, true, "main");
+        iom.schedule(test_sock);
+        return 0;
+    }
+
+    test_write_block();
+    test_write_only_event();
     return 0;
 }
@@ -1,4 +1,5 @@
 #include "../src/FL/http/http.h"
+#include "../src/FL/macro.h"
 
 void test_requese() {
 
@@ -18,7 +19,28 @@ void test_response() {
     rsp->dump(std::cout) << std::endl;
 }
 
+void test_params() {
+    FL::http::HttpRequest::ptr req(new FL::http::HttpRequest);
+    req->setQuery("name=%E4%BD%A0%E5%A5%BD&a+b=1%2B1&flag&&id=7&id=8&bad=%zz");
+    req->setHeader("Content-Type", "application/x-www-form-urlencoded; charset=utf-8");
+    req->setBody("id=9&form=x+y");
+    req->setHeader("Cookie", "sid=abc123; theme = dark ;empty=; =bad");
+    // 路由参数优先
+    req->setParam("route", "r");
+
+    FL_ASSERT(req->getParam("name") == "你好");
+    FL_ASSERT(req->getParam("a b") == "1+1");
+    FL_ASSERT(req->hasParam("flag") && req->getParam("flag").empty());
+    FL_ASSERT(req->getParamAs<int>("id") == 7);
+    FL_ASSERT(req->getParam("bad") == "%zz");
+    FL_ASSERT(req->getParam("form") == "x y");
+    FL_ASSERT(req->getParam("route") == "r");
+    FL_ASSERT(req->getCookie("sid") == "abc123" && req->getCookie("theme") == "dark");
+    FL_ASSERT(req->hasCookie("empty") && req->getCookies().size() == 3);
+}
+
 int main(int argc, char** argv) {
+    test_params();
 
     test_requese();
     std::cout << std::endl;
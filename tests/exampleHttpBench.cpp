@@ -0,0 +1,140 @@
+#include "../src/FL/http/http_server.h"
+#include "../src/FL/config.h"
+#include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+#include "../src/FL/util.h"
+#include <string.h>
+#include <new>
+
+auto lg = FL_LOG_ROOT();
+
+// 统计堆分配次数
+static size_t s_alloc_count = 0;
+
+void* operator new(size_t size) {
+    ++s_alloc_count;
+    void* p = malloc(size);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void* p) noexcept {
+    free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+// std::pmr::new_delete_resource使用带对齐参数的版本
+void* operator new(size_t size, std::align_val_t align) {
+    ++s_alloc_count;
+    void* p = aligned_alloc((size_t)align, (size + (size_t)align - 1) / (size_t)align * (size_t)align);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    free(p);
+}
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    free(p);
+}
+
+static const char s_request[] =
+    "GET /bench?id=42&name=fl HTTP/1.1\r\n"
+    "Host: 127.0.0.1:18940\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/118.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Cookie: sid=0123456789abcdef; theme=dark\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n\r\n";
+
+static const char* s_addr = "127.0.0.1:18940";
+
+// 在一个keep-alive连接上发送count个请求, 每批pipeline个流水线发送, 返回是否全部成功
+static bool RunClient(int count, int pipeline) {
+    FL::Address::ptr addr = FL::Address::LookupAnyIPAddress(s_addr);
+    FL::Socket::ptr sock = FL::Socket::CreateTCP(addr);
+    if(!sock->connect(addr)) {
+        return false;
+    }
+    std::string batch;
+    for(int i = 0; i < pipeline; ++i) {
+        batch.append(s_request, sizeof(s_request) - 1);
+    }
+    static char buf[256 * 1024];
+    size_t rsp_len = 0;
+    for(int i = 0; i < count; i += pipeline) {
+        if(sock->send(batch.c_str(), batch.size()) != (int)batch.size()) {
+            return false;
+        }
+        size_t len = 0;
+        while(!rsp_len || len < rsp_len * pipeline) {
+            int rt = sock->recv(buf + len, sizeof(buf) - 1 - len);
+            if(rt <= 0) {
+                return false;
+            }
+            len += rt;
+            if(!rsp_len) {
+                // 由第一个响应确定长度, 所有响应长度相同
+                buf[len] = '\0';
+                const char* end = strstr(buf, "\r\n\r\n");
+                const char* cl = strcasestr(buf, "content-length: ");
+                if(end && cl) {
+                    rsp_len = end + 4 - buf + atoi(cl + 16);
+                }
+            }
+        }
+    }
+    sock->close();
+    return true;
+}
+
+static void Bench(const char* name, int count, int pipeline) {
+    RunClient(pipeline * 10, pipeline);     // 预热
+    size_t allocs = s_alloc_count;
+    uint64_t start = FL::UT::GetCurrentUs();
+    FL_ASSERT(RunClient(count, pipeline));
+    uint64_t used = FL::UT::GetCurrentUs() - start;
+    FL_LOG_INFO(lg) << name << " pipeline=" << pipeline << ": " << count * 1000000ull / used
+                    << " requests/sec, " << (double)(s_alloc_count - allocs) / count
+                    << " allocations/request";
+}
+
+void task() {
+    FL::http::HttpServer::ptr server(new FL::http::HttpServer(true));
+    // 每轮测试都在一个连接上发送全部请求
+    server->setMaxRequestsPerConnection(0);
+    FL_ASSERT(server->bind(FL::Address::LookupAnyIPAddress(s_addr)));
+    server->getServletDispath()->addServlet("/bench", [](FL::http::HttpRequest::ptr req
+                                            , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        rsp->setHeader("Content-Type", "text/plain");
+        rsp->setHeader("X-Id", req->getParam("id"));
+        rsp->setBody("hello fl");
+        return 0;
+    });
+    server->start();
+
+    const int count = 20000;
+    auto arena_size = FL::Config::Lookup<uint64_t>("http.session.arena_size");
+    // pipeline=1时每个请求都要等待读写事件, 分配主要来自IO调度(定时器, 协程调度);
+    // 流水线时IO开销被摊薄, 剩下的主要是HTTP处理本身的分配
+    Bench("arena", count, 1);
+    Bench("arena", count, 32);
+    arena_size->setVal(0);
+    Bench("heap", count, 1);
+    Bench("heap", count, 32);
+    server->stop();
+}
+
+int main(int argc, char** argv) {
+    FL_SYS_LOG()->setLevel(FL::LogLevel::Level::INFO);
+    FL::IOManager iom(1);
+    iom.schedule(task);
+    return 0;
+}
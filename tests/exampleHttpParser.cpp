@@ -1,15 +1,70 @@
 #include "../src/FL/http/http_parser.h"
 #include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+#include "../src/FL/util.h"
+#include <string.h>
 #include <string>
 #include <iostream>
+#include <new>
 
 auto lg = FL_LOG_ROOT();
 
+// 统计堆分配次数
+static size_t s_alloc_count = 0;
+
+void* operator new(size_t size) {
+    ++s_alloc_count;
+    void* p = malloc(size);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void* p) noexcept {
+    free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+// std::pmr::new_delete_resource使用带对齐参数的版本
+void* operator new(size_t size, std::align_val_t align) {
+    ++s_alloc_count;
+    void* p = aligned_alloc((size_t)align, (size + (size_t)align - 1) / (size_t)align * (size_t)align);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    free(p);
+}
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    free(p);
+}
+
 char request_data[] = "GET / HTTP/1.1\r\n"
                       "Host: www.baidu.com\r\n"
                       "Content-Length: 10\r\n\r\n"
                       "1234567890";
 
+static const char s_browser_request[] =
+    "GET /api/v1/items?page=2 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"118\", \"Not=A?Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/118.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,*/*;q=0.8\r\n"
+    "Sec-Fetch-Site: none\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n\r\n";
+
 void test() {
     FL::http::HttpRequestParser parser;
     size_t size = parser.execute(request_data, sizeof(request_data) - 1);
@@ -20,7 +75,55 @@ void test() {
     FL_LOG_INFO(lg) << "\n" << parser.getData()->toString();
 }
 
+void test_headers() {
+    FL::http::HttpHeaders h;
+    h.set("Content-Type", "text/plain");
+    h.set("content-type", "text/html; charset=utf-8");
+    h.set("X-A", "1");
+    FL_ASSERT(h.size() == 2 && h.get("CONTENT-TYPE") == "text/html; charset=utf-8");
+    h.set("content-type", "a");
+    FL_ASSERT(h.get("Content-Type") == "a");
+    // 值引用自身存储
+    h.set("X-B", h.get("content-type"));
+    FL_ASSERT(h.get("x-b") == "a");
+    FL_ASSERT(h.del("x-a") && !h.has("X-A") && h.size() == 2);
+
+    for(int i = 0; i < 40; ++i) {
+        h.set("k" + std::to_string(i), std::to_string(i));
+    }
+    FL::http::HttpHeaders copy = h;
+    FL_ASSERT(copy.size() == 42 && copy.get("K39") == "39");
+    int n = 0;
+    for(auto it : copy) {
+        n += !it.first.empty();
+    }
+    FL_ASSERT(n == 42);
+}
+
+void bench_parse() {
+    const int LOOP = 100000;
+    std::string buf;
+    FL::http::HttpRequestParser::ptr parser(new FL::http::HttpRequestParser);
+    size_t allocs = s_alloc_count;
+    uint64_t start = FL::UT::GetCurrentUs();
+    for(int i = 0; i < LOOP; ++i) {
+        parser->reset();
+        buf.assign(s_browser_request, sizeof(s_browser_request) - 1);
+        parser->execute(&buf[0], buf.size());
+        FL_ASSERT(parser->isFinish() && !parser->hasError());
+    }
+    uint64_t used = FL::UT::GetCurrentUs() - start;
+    auto req = parser->getData();
+    FL_ASSERT(req->getHeaders().size() == 15);
+    FL_ASSERT(req->getHeader("accept-language") == "zh-CN,zh;q=0.9,en;q=0.8");
+    FL_LOG_INFO(lg) << "parse " << req->getHeaders().size() << "-header request: "
+                    << used * 1000 / LOOP << "ns/op, "
+                    << (double)(s_alloc_count - allocs) / LOOP << " allocs/op";
+}
+
 int main(int argc, char** argv) {
     test();
+    test_headers();
+    bench_parse();
     return 0;
 }
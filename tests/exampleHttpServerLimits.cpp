@@ -0,0 +1,197 @@
+#include "../src/FL/http/http_server.h"
+#include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+#include "../src/FL/util.h"
+#include <string.h>
+
+auto lg = FL_LOG_ROOT();
+
+static const char* s_addr = "127.0.0.1:18941";
+
+static FL::Socket::ptr Connect() {
+    FL::Address::ptr addr = FL::Address::LookupAnyIPAddress(s_addr);
+    FL::Socket::ptr sock = FL::Socket::CreateTCP(addr);
+    if(!sock->connect(addr)) {
+        return nullptr;
+    }
+    sock->setRecvTimeout(2000);
+    return sock;
+}
+
+static bool SendGet(FL::Socket::ptr sock, const std::string& path) {
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    return sock->send(req.c_str(), req.size(), MSG_NOSIGNAL) == (int)req.size();
+}
+
+// 读取一个完整的响应, 超时或连接关闭时返回空
+static std::string RecvResponse(FL::Socket::ptr sock) {
+    std::string rsp;
+    char buf[4096];
+    size_t total = 0;
+    while(!total || rsp.size() < total) {
+        int rt = sock->recv(buf, sizeof(buf));
+        if(rt <= 0) {
+            return "";
+        }
+        rsp.append(buf, rt);
+        size_t pos = rsp.find("\r\n\r\n");
+        if(!total && pos != std::string::npos) {
+            const char* cl = strcasestr(rsp.c_str(), "content-length: ");
+            total = pos + 4 + (cl ? atoi(cl + 16) : 0);
+        }
+    }
+    return rsp;
+}
+
+// 对端关闭连接时返回true
+static bool IsClosed(FL::Socket::ptr sock) {
+    char c;
+    return sock->recv(&c, 1) == 0;
+}
+
+static void test_keepalive_timeout(FL::http::HttpServer::ptr server) {
+    server->setKeepaliveTimeout(200);
+    auto sock = Connect();
+    FL_ASSERT(sock && SendGet(sock, "/fast"));
+    FL_ASSERT(!RecvResponse(sock).empty());
+    uint64_t start = FL::UT::GetCurrentMs();
+    FL_ASSERT(IsClosed(sock));
+    uint64_t used = FL::UT::GetCurrentMs() - start;
+    FL_ASSERT(used >= 150 && used < 1000);
+    server->setKeepaliveTimeout(30 * 1000);
+    FL_LOG_INFO(lg) << "keepalive timeout ok, closed after " << used << "ms";
+}
+
+// keep-alive的空闲超时只用于等待下一个请求, 不能留在连接上影响之后读取请求体
+static void test_slow_body(FL::http::HttpServer::ptr server) {
+    uint64_t read_timeout = server->getReadTimeout();
+    server->setKeepaliveTimeout(200);
+    server->setReadTimeout((uint64_t)-1);
+    auto sock = Connect();
+    FL_ASSERT(sock && SendGet(sock, "/fast"));
+    FL_ASSERT(!RecvResponse(sock).empty());
+    // 第二个请求经过了空闲等待, 请求体每段间隔都超过空闲超时
+    std::string head = "POST /body HTTP/1.1\r\nHost: 127.0.0.1\r\ncontent-length: 9\r\n\r\n";
+    FL_ASSERT(sock->send(head.c_str(), head.size(), MSG_NOSIGNAL) == (int)head.size());
+    for(auto part : {"abc", "def", "ghi"}) {
+        usleep(300 * 1000);
+        FL_ASSERT(sock->send(part, 3, MSG_NOSIGNAL) == 3);
+    }
+    std::string rsp = RecvResponse(sock);
+    FL_ASSERT(rsp.find("abcdefghi") != std::string::npos);
+    server->setKeepaliveTimeout(30 * 1000);
+    server->setReadTimeout(read_timeout);
+    FL_LOG_INFO(lg) << "slow body after keep-alive wait ok";
+}
+
+static void test_max_requests(FL::http::HttpServer::ptr server) {
+    server->setMaxRequestsPerConnection(3);
+    auto sock = Connect();
+    FL_ASSERT(sock);
+    for(int i = 1; i <= 3; ++i) {
+        FL_ASSERT(SendGet(sock, "/fast"));
+        std::string rsp = RecvResponse(sock);
+        FL_ASSERT(!rsp.empty());
+        bool close = strcasestr(rsp.c_str(), "connection: close") != nullptr;
+        FL_ASSERT(close == (i == 3));
+    }
+    FL_ASSERT(IsClosed(sock));
+    server->setMaxRequestsPerConnection(0);
+    FL_LOG_INFO(lg) << "max requests per connection ok";
+}
+
+static void test_max_connections(FL::http::HttpServer::ptr server) {
+    server->setMaxConnections(1);
+    auto a = Connect();
+    FL_ASSERT(a && SendGet(a, "/fast"));
+    FL_ASSERT(!RecvResponse(a).empty());
+
+    // 连接已满, b停留在监听队列中得不到响应
+    auto b = Connect();
+    FL_ASSERT(b && SendGet(b, "/fast"));
+    b->setRecvTimeout(300);
+    FL_ASSERT(RecvResponse(b).empty());
+    FL_ASSERT(server->getConnections() == 1);
+
+    // a关闭后b被accept
+    a->close();
+    b->setRecvTimeout(2000);
+    FL_ASSERT(SendGet(b, "/fast"));
+    FL_ASSERT(!RecvResponse(b).empty());
+    b->close();
+    server->setMaxConnections(0);
+    FL_LOG_INFO(lg) << "max connections ok";
+}
+
+static void test_graceful_stop(FL::http::HttpServer::ptr server) {
+    auto idle = Connect();
+    auto busy = Connect();
+    FL_ASSERT(idle && busy && SendGet(busy, "/slow"));
+    // 请求只发送了一部分的连接不算空闲, 停止时不能被关闭
+    auto partial = Connect();
+    std::string req = "GET /fast HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    FL_ASSERT(partial && partial->send(req.c_str(), 10, MSG_NOSIGNAL) == 10);
+    usleep(50 * 1000);
+    FL_ASSERT(server->getConnections() == 3);
+
+    bool stopped = false;
+    FL::IOManager::GetThis()->schedule([server, &stopped]() {
+        stopped = server->gracefulStop(2000);
+    });
+    // 空闲连接立即关闭, 处理中的请求正常完成并带上connection: close
+    FL_ASSERT(IsClosed(idle));
+    usleep(50 * 1000);
+    FL_ASSERT(partial->send(req.c_str() + 10, req.size() - 10, MSG_NOSIGNAL) == (int)req.size() - 10);
+    std::string partial_rsp = RecvResponse(partial);
+    FL_ASSERT(partial_rsp.find("fast") != std::string::npos);
+    FL_ASSERT(strcasestr(partial_rsp.c_str(), "connection: close"));
+    std::string rsp = RecvResponse(busy);
+    FL_ASSERT(rsp.find("slow done") != std::string::npos);
+    FL_ASSERT(strcasestr(rsp.c_str(), "connection: close"));
+    FL_ASSERT(IsClosed(busy));
+    usleep(50 * 1000);
+    FL_ASSERT(stopped && server->getConnections() == 0);
+    // 监听套接字已关闭, 新连接得不到服务
+    auto late = Connect();
+    FL_ASSERT(!late || !SendGet(late, "/fast") || RecvResponse(late).empty());
+    FL_LOG_INFO(lg) << "graceful stop ok";
+}
+
+void task() {
+    FL::http::HttpServer::ptr server(new FL::http::HttpServer(true));
+    FL_ASSERT(server->bind(FL::Address::LookupAnyIPAddress(s_addr)));
+    auto sd = server->getServletDispath();
+    sd->addServlet("/fast", [](FL::http::HttpRequest::ptr req
+                               , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        rsp->setBody("fast");
+        return 0;
+    });
+    sd->addServlet("/body", [](FL::http::HttpRequest::ptr req
+                               , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        rsp->setBody(req->getBody());
+        return 0;
+    });
+    sd->addServlet("/slow", [](FL::http::HttpRequest::ptr req
+                               , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        usleep(300 * 1000);
+        rsp->setBody("slow done");
+        return 0;
+    });
+    server->start();
+
+    test_keepalive_timeout(server);
+    test_slow_body(server);
+    test_max_requests(server);
+    test_max_connections(server);
+    test_graceful_stop(server);
+}
+
+int main(int argc, char** argv) {
+    FL_SYS_LOG()->setLevel(FL::LogLevel::Level::ERROR);
+    FL::IOManager iom(2);
+    iom.schedule(task);
+    return 0;
+}
@@ -0,0 +1,410 @@
+#include "../src/FL/http/http_server.h"
+#include "../src/FL/config.h"
+#include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+#include <stdlib.h>
+#include <string.h>
+
+auto lg = FL_LOG_ROOT();
+
+static const char* s_addr = "127.0.0.1:18943";
+
+struct Response {
+    int status = 0;
+    std::string head;
+    std::string body;
+
+    std::string header(const char* name) const {
+        std::string key = std::string("\r\n") + name + ": ";
+        const char* p = strcasestr(head.c_str(), key.c_str());
+        if(!p) {
+            return "";
+        }
+        p += key.size();
+        return std::string(p, strstr(p, "\r\n") - p);
+    }
+};
+
+// 一个连接的客户端, 接收缓冲区跨响应保留, 以便检查流水线和多余的数据
+class Client {
+  public:
+    Client() {
+        FL::Address::ptr addr = FL::Address::LookupAnyIPAddress(s_addr);
+        m_sock = FL::Socket::CreateTCP(addr);
+        FL_ASSERT(m_sock->connect(addr));
+        m_sock->setRecvTimeout(2000);
+    }
+
+    void send(const std::string& data) {
+        FL_ASSERT(m_sock->send(data.c_str(), data.size(), MSG_NOSIGNAL) == (int)data.size());
+    }
+
+    // 逐字节发送, 每个字节单独到达服务器
+    void sendSlowly(const std::string& data) {
+        for(char c : data) {
+            send(std::string(1, c));
+            usleep(1000);
+        }
+    }
+
+    // 读取一个响应, 支持content-length, chunked和以关闭连接结束的消息体
+    Response recv() {
+        Response rsp;
+        size_t pos;
+        while((pos = m_buf.find("\r\n\r\n")) == std::string::npos) {
+            FL_ASSERT(fill());
+        }
+        rsp.head = m_buf.substr(0, pos + 2);
+        rsp.status = atoi(rsp.head.c_str() + 9);
+        m_buf.erase(0, pos + 4);
+        if(rsp.status == 100) {
+            return rsp;
+        }
+        if(strcasestr(rsp.header("transfer-encoding").c_str(), "chunked")) {
+            while(true) {
+                while((pos = m_buf.find("\r\n")) == std::string::npos) {
+                    FL_ASSERT(fill());
+                }
+                size_t size = strtoul(m_buf.c_str(), nullptr, 16);
+                while(m_buf.size() < pos + 2 + size + 2) {
+                    FL_ASSERT(fill());
+                }
+                FL_ASSERT(m_buf.compare(pos + 2 + size, 2, "\r\n") == 0);
+                rsp.body.append(m_buf, pos + 2, size);
+                m_buf.erase(0, pos + 2 + size + 2);
+                if(size == 0) {
+                    break;
+                }
+            }
+        } else if(!rsp.header("content-length").empty()) {
+            size_t length = strtoull(rsp.header("content-length").c_str(), nullptr, 10);
+            while(m_buf.size() < length) {
+                FL_ASSERT(fill());
+            }
+            rsp.body = m_buf.substr(0, length);
+            m_buf.erase(0, length);
+        } else {
+            while(fill()) {
+            }
+            rsp.body.swap(m_buf);
+        }
+        return rsp;
+    }
+
+    // 服务器是否已关闭连接且没有发送任何数据
+    bool isClosed() {
+        return m_buf.empty() && !fill();
+    }
+
+    // 接收直到缓冲区中出现str, 不消费数据
+    bool waitFor(const std::string& str) {
+        while(m_buf.find(str) == std::string::npos) {
+            if(!fill()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::string& pending() const {
+        return m_buf;
+    }
+  private:
+    bool fill() {
+        char buf[4096];
+        int rt = m_sock->recv(buf, sizeof(buf));
+        if(rt <= 0) {
+            return false;
+        }
+        m_buf.append(buf, rt);
+        return true;
+    }
+  private:
+    FL::Socket::ptr m_sock;
+    std::string m_buf;
+};
+
+static std::string Post(const std::string& path, const std::string& headers, const std::string& body) {
+    return "POST " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n" + headers + "\r\n" + body;
+}
+
+static std::string Get(const std::string& path) {
+    return "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+}
+
+static const char* s_chunked = "Transfer-Encoding: chunked\r\n";
+
+static void test_chunk_ext_trailer() {
+    Client c;
+    c.send(Post("/body", s_chunked
+                , "5;name=value\r\nhello\r\n6 ; ext\r\n world\r\n0\r\nX-Trailer: t\r\nX-Other: o\r\n\r\n"));
+    Response rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "hello world");
+    // 解码后去掉transfer-encoding头
+    FL_ASSERT(rsp.header("x-te").empty());
+
+    // 大写十六进制和空消息体
+    c.send(Post("/body", s_chunked, "A\r\n0123456789\r\n0\r\n\r\n"));
+    rsp = c.recv();
+    FL_ASSERT(rsp.body == "0123456789");
+    c.send(Post("/body", s_chunked, "0\r\n\r\n"));
+    rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body.empty());
+    FL_LOG_INFO(lg) << "chunk extension and trailer ok";
+}
+
+static void test_chunk_split() {
+    Client c;
+    // 大小行, 数据, 块结尾的\r\n和trailer都被拆到多次读取中
+    c.sendSlowly(Post("/body", s_chunked, "3\r\nabc\r\n10;x=y\r\n0123456789abcdef\r\n0\r\nT: 1\r\n\r\n"));
+    Response rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "abc0123456789abcdef");
+
+    c.sendSlowly(Post("/echo", s_chunked, "4\r\necho\r\n0\r\n\r\n"));
+    rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "echo");
+    FL_LOG_INFO(lg) << "chunks split across reads ok";
+}
+
+static void test_pipeline_after_chunked() {
+    Client c;
+    c.send(Post("/body", s_chunked, "3\r\none\r\n0\r\n\r\n")
+           + Get("/body")
+           + Post("/body", s_chunked, "5\r\nthree\r\n0\r\nT: 1\r\n\r\n")
+           + Post("/body", "content-length: 4\r\n", "four"));
+    const char* bodies[] = {"one", "", "three", "four"};
+    for(auto body : bodies) {
+        Response rsp = c.recv();
+        FL_ASSERT(rsp.status == 200 && rsp.body == body);
+    }
+    FL_ASSERT(c.pending().empty());
+    FL_LOG_INFO(lg) << "pipeline after chunked body ok";
+}
+
+static void test_malformed_chunk() {
+    const char* bodies[] = {
+        "zz\r\nhello\r\n0\r\n\r\n",                 // 非十六进制
+        "\r\nhello\r\n0\r\n\r\n",                   // 空的大小行
+        "5x\r\nhello\r\n0\r\n\r\n",                 // 大小后的非法字符
+        "10000000000000000\r\nhello\r\n0\r\n\r\n",  // 超过16位十六进制
+        "5\r\nhelloXX0\r\n\r\n",                    // 块数据后没有\r\n
+    };
+    for(auto body : bodies) {
+        Client c;
+        c.send(Post("/body", s_chunked, body));
+        FL_ASSERT(c.isClosed());
+    }
+    FL_LOG_INFO(lg) << "malformed chunk size ok";
+}
+
+static void test_unread_body() {
+    Client c;
+    // servlet没有读取消息体, 服务器丢弃它后继续处理下一个请求
+    c.send(Post("/unread", "content-length: 10\r\n", "0123456789"));
+    Response rsp = c.recv();
+    FL_ASSERT(rsp.body == "ignored");
+    c.send(Post("/unread", s_chunked, "3\r\nabc\r\n4\r\ndefg\r\n0\r\n\r\n"));
+    rsp = c.recv();
+    FL_ASSERT(rsp.body == "ignored");
+    c.send(Get("/body"));
+    rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body.empty());
+    FL_LOG_INFO(lg) << "keep-alive after unread body ok";
+}
+
+static void test_stream_response() {
+    Client c;
+    c.send(Get("/stream"));
+    Response rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "hello world");
+    FL_ASSERT(rsp.header("transfer-encoding") == "chunked");
+    FL_ASSERT(rsp.header("connection") == "keep-alive");
+
+    c.send(Post("/echo", "content-length: 5\r\n", "12345"));
+    rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "12345");
+    FL_ASSERT(c.pending().empty());
+
+    // HTTP/1.0没有chunked, 以关闭连接结束消息体
+    Client c10;
+    c10.send("GET /stream HTTP/1.0\r\nConnection: keep-alive\r\n\r\n");
+    rsp = c10.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "hello world");
+    FL_ASSERT(rsp.header("transfer-encoding").empty() && rsp.header("content-length").empty());
+    FL_ASSERT(rsp.header("connection") == "close");
+    FL_LOG_INFO(lg) << "stream response ok";
+}
+
+static void test_body_limit() {
+    auto max_body = FL::Config::Lookup<uint64_t>("http.request.max_body_size");
+    uint64_t old_max = max_body->getVal();
+    max_body->setVal(64);
+
+    // 声明的长度超限时直接回复413, 不发送100 Continue, 也不读取消息体
+    {
+        Client c;
+        c.send(Post("/body", "content-length: 100\r\nExpect: 100-continue\r\n", ""));
+        Response rsp = c.recv();
+        FL_ASSERT(rsp.status == 413 && rsp.header("connection") == "close");
+        FL_ASSERT(c.isClosed());
+    }
+    {
+        Client c;
+        c.send(Post("/body", "content-length: 65\r\n", std::string(65, 'x')));
+        Response rsp = c.recv();
+        FL_ASSERT(rsp.status == 413);
+    }
+    // chunked消息体在中途超限
+    {
+        Client c;
+        std::string chunk = "20\r\n" + std::string(32, 'x') + "\r\n";
+        c.send(Post("/body", s_chunked, chunk + chunk + chunk + "0\r\n\r\n"));
+        Response rsp = c.recv();
+        FL_ASSERT(rsp.status == 413 && rsp.header("connection") == "close");
+    }
+    // 正好等于上限时正常处理
+    {
+        Client c;
+        std::string chunk = "20\r\n" + std::string(32, 'x') + "\r\n";
+        c.send(Post("/body", s_chunked, chunk + chunk + "0\r\n\r\n"));
+        Response rsp = c.recv();
+        FL_ASSERT(rsp.status == 200 && rsp.body.size() == 64);
+    }
+    // servlet的上限覆盖全局配置, 更大或更小都可以
+    {
+        Client c;
+        c.send(Post("/big", "content-length: 500\r\n", std::string(500, 'b')));
+        Response rsp = c.recv();
+        FL_ASSERT(rsp.status == 200 && rsp.body == std::string(500, 'b'));
+        c.send(Post("/big", "content-length: 1001\r\n", ""));
+        rsp = c.recv();
+        FL_ASSERT(rsp.status == 413);
+    }
+    {
+        Client c;
+        c.send(Post("/tiny", "content-length: 9\r\n", "123456789"));
+        Response rsp = c.recv();
+        FL_ASSERT(rsp.status == 413);
+    }
+    max_body->setVal(old_max);
+    FL_LOG_INFO(lg) << "body limit ok";
+}
+
+static void test_continue() {
+    Client c;
+    // 普通servlet读取消息体之前发送100 Continue
+    c.send(Post("/body", "content-length: 5\r\nExpect: 100-continue\r\n", ""));
+    Response rsp = c.recv();
+    FL_ASSERT(rsp.status == 100);
+    c.send("hello");
+    rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "hello");
+
+    // 流式servlet先开始响应再读消息体, 100 Continue在最终响应之前一起发出
+    c.send(Post("/echo", "content-length: 5\r\nExpect: 100-continue\r\n", ""));
+    FL_ASSERT(c.waitFor("HTTP/1.1 200"));
+    FL_ASSERT(c.pending().compare(0, 25, "HTTP/1.1 100 Continue\r\n\r\n") == 0);
+    rsp = c.recv();
+    FL_ASSERT(rsp.status == 100);
+    c.send("world");
+    rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "world");
+    FL_ASSERT(c.pending().empty());
+
+    // servlet没有读取消息体时不发送100 Continue, 响应后关闭连接
+    c.send(Post("/unread", "content-length: 5\r\nExpect: 100-continue\r\n", ""));
+    rsp = c.recv();
+    FL_ASSERT(rsp.status == 200 && rsp.body == "ignored");
+    FL_ASSERT(c.isClosed());
+    FL_LOG_INFO(lg) << "100 continue ok";
+}
+
+static void test_invalid_content_length() {
+    const char* values[] = {"abc", "12abc", "1 2"};
+    for(auto value : values) {
+        Client c;
+        c.send(Post("/body", std::string("content-length: ") + value + "\r\n", "12"));
+        FL_ASSERT(c.isClosed());
+    }
+    FL_LOG_INFO(lg) << "invalid content-length ok";
+}
+
+void task() {
+    FL::http::HttpServer::ptr server(new FL::http::HttpServer(true));
+    FL_ASSERT(server->bind(FL::Address::LookupAnyIPAddress(s_addr)));
+    auto sd = server->getServletDispath();
+    sd->addServlet("/body", [](FL::http::HttpRequest::ptr req
+                               , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        rsp->setHeader("X-TE", req->getHeader("transfer-encoding"));
+        rsp->setBody(req->getBody());
+        return 0;
+    });
+
+    FL::http::Servlet::ptr echo(new FL::http::FunctionServlet([](FL::http::HttpRequest::ptr req
+                                , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        session->beginResponse(rsp);
+        char buf[3];
+        int len = 0;
+        while((len = session->readBody(buf, sizeof(buf))) > 0) {
+            if(session->writeBody(buf, len) <= 0) {
+                break;
+            }
+        }
+        return 0;
+    }));
+    echo->setStreamBody(true);
+    sd->addServlet("/echo", echo);
+
+    FL::http::Servlet::ptr unread(new FL::http::FunctionServlet([](FL::http::HttpRequest::ptr req
+                                  , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        rsp->setBody("ignored");
+        return 0;
+    }));
+    unread->setStreamBody(true);
+    sd->addServlet("/unread", unread);
+
+    sd->addServlet("/stream", [](FL::http::HttpRequest::ptr req
+                                 , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        session->beginResponse(rsp);
+        session->writeBody("hello ", 6);
+        session->writeBody("world", 5);
+        return 0;
+    });
+    sd->addServlet("/big", [](FL::http::HttpRequest::ptr req
+                              , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        rsp->setBody(req->getBody());
+        return 0;
+    });
+    sd->getMatchServlet("/big")->setMaxBodySize(1000);
+    sd->addServlet("/tiny", [](FL::http::HttpRequest::ptr req
+                               , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        rsp->setBody(req->getBody());
+        return 0;
+    });
+    sd->getMatchServlet("/tiny")->setMaxBodySize(8);
+    server->start();
+
+    test_chunk_ext_trailer();
+    test_chunk_split();
+    test_pipeline_after_chunked();
+    test_malformed_chunk();
+    test_unread_body();
+    test_stream_response();
+    test_body_limit();
+    test_continue();
+    test_invalid_content_length();
+    server->stop();
+}
+
+int main(int argc, char** argv) {
+    FL_SYS_LOG()->setLevel(FL::LogLevel::Level::ERROR);
+    FL::IOManager iom(2);
+    iom.schedule(task);
+    return 0;
+}
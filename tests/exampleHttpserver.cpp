@@ -16,6 +16,24 @@ void task() {
         rsp->setBody(req->toString());
         return 0;
     });
+    // 声明的消息体超过1KB时直接返回413
+    sd->getMatchServlet("/FL/XX")->setMaxBodySize(1024);
+    // 流式回显: 边读请求消息体边以chunked编码返回
+    FL::http::Servlet::ptr echo(new FL::http::FunctionServlet([](FL::http::HttpRequest::ptr req
+                                , FL::http::HttpResponse::ptr rsp
+    , FL::http::HttpSession::ptr session) {
+        session->beginResponse(rsp);
+        char buf[4096];
+        int len = 0;
+        while((len = session->readBody(buf, sizeof(buf))) > 0) {
+            if(session->writeBody(buf, len) <= 0) {
+                break;
+            }
+        }
+        return 0;
+    }));
+    echo->setStreamBody(true);
+    sd->addServlet("/FL/echo", echo);
     server->start();
     sd->addGlobServlet("/FL/*", [](FL::http::HttpRequest::ptr req
                              , FL::http::HttpResponse::ptr rsp
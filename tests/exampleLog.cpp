@@ -1,10 +1,78 @@
 #include "../src/FL_LogManager.h"
+#include <assert.h>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
+#include <time.h>
 #include <unistd.h>
 
+static uint64_t MonotonicSec() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec;
+}
+
+// 多线程同时争用一个限流器, 每个窗口放行的条数不能超过上限
+static void test_rate_limiter_concurrent() {
+    const uint32_t max_per_sec = 5;
+    FL::LogRateLimiter limiter;
+    std::atomic<uint64_t> allowed{0};
+    uint64_t start = MonotonicSec();
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            uint64_t suppressed;
+            for(int j = 0; j < 200000; ++j) {
+                if(limiter.allow(max_per_sec, suppressed)) {
+                    ++allowed;
+                }
+            }
+        });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    uint64_t windows = MonotonicSec() - start + 1;
+    assert(allowed <= windows * max_per_sec);
+    assert(allowed >= max_per_sec);
+}
+
+// 多线程同时创建和查找日志器, 同名日志器只创建一次, 返回的引用一直有效
+static void test_logger_lookup_concurrent() {
+    const int thread_count = 8;
+    const int name_count = 200;
+    std::vector<std::vector<const FL::Logger::ptr*> > handles(thread_count);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([i, &handles]() {
+            for(int j = 0; j < name_count; ++j) {
+                const FL::Logger::ptr& logger = FL::LogManager::GetInstance()->getLogger("lookup_" + std::to_string(j));
+                assert(logger->getName() == "lookup_" + std::to_string(j));
+                handles[i].push_back(&logger);
+                assert(FL_SYS_LOG()->getName() == "system");
+            }
+        });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    for(int j = 0; j < name_count; ++j) {
+        const FL::Logger::ptr& logger = FL::LogManager::GetInstance()->getLogger("lookup_" + std::to_string(j));
+        for(int i = 0; i < thread_count; ++i) {
+            assert(handles[i][j] == &logger);
+        }
+    }
+}
+
 int main(int argc, char** argv) {
+    test_rate_limiter_concurrent();
+    test_logger_lookup_concurrent();
 
     FL::Logger::ptr logger = FL_LOG_NAME("lzc");
+    // 调用点缓存的就是管理器中的日志器
+    assert(&FL_LOG_NAME("lzc") == &FL::LogManager::GetInstance()->getLogger("lzc"));
+    assert(&FL_SYS_LOG() == &FL::LogManager::GetInstance()->getLogger("system"));
     FL::StdOutLogAppender::ptr console = std::make_shared<FL::StdOutLogAppender>();
     FL::FileLogAppender::ptr file = std::make_shared<FL::FileLogAppender>("examplelog.log");
     logger->addAppender(console);
@@ -17,5 +85,10 @@ int main(int argc, char** argv) {
 
     FL_LOG_INFO(FL_SYS_LOG()) << "system log";
 
+    for(int i = 0 ; i < 1000 ; ++i) {
+        FL_LOG_INFO_RATE(logger, 5) << "rate limited i=" << i;
+        FL_LOG_INFO_SAMPLE(logger, 100) << "sampled i=" << i;
+    }
+
     return 0;
 }
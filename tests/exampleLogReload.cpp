@@ -0,0 +1,78 @@
+#include "../src/FL_LogManager.h"
+#include "../src/FL_Thread.h"
+#include "../src/FL/config.h"
+#include "../src/FL/macro.h"
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// 32个线程持续输出日志的同时反复重载日志配置,检查没有日志丢失
+
+static const int s_thread_count = 32;
+static const int s_log_count = 5000;
+static const int s_reload_count = 200;
+
+static const char* s_configs[] = {
+    "logs:\n"
+    "    - name: reload\n"
+    "      level: info\n"
+    "      formatter: '%m%n'\n"
+    "      appenders:\n"
+    "          - type: FileLogAppender\n"
+    "            file: reload_a.log\n",
+    "logs:\n"
+    "    - name: reload\n"
+    "      level: debug\n"
+    "      formatter: '%t %m%n'\n"
+    "      appenders:\n"
+    "          - type: FileLogAppender\n"
+    "            file: reload_b.log\n"
+};
+
+static uint64_t countLines(const std::string& file) {
+    std::ifstream ifs(file);
+    uint64_t count = 0;
+    char ch;
+    while(ifs.get(ch)) {
+        if(ch == '\n') {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    std::ofstream("reload_a.log", std::ios::trunc);
+    std::ofstream("reload_b.log", std::ios::trunc);
+
+    FL::Config::LoadFromYaml(YAML::Load(s_configs[0]));
+    FL::Logger::ptr logger = FL_LOG_NAME("reload");
+
+    std::atomic<int> running{s_thread_count};
+    std::vector<FL::Thread::ptr> threads;
+    for(int i = 0 ; i < s_thread_count ; ++i) {
+        threads.push_back(std::make_shared<FL::Thread>("reload_" + std::to_string(i), [&running]() {
+            for(int j = 0 ; j < s_log_count ; ++j) {
+                FL_LOG_INFO(FL_LOG_NAME("reload")) << "reload test j=" << j;
+            }
+            --running;
+        }));
+    }
+
+    int reloads = 0;
+    while(running > 0 || reloads < s_reload_count) {
+        FL::Config::LoadFromYaml(YAML::Load(s_configs[++reloads % 2]));
+    }
+
+    for(auto& th : threads) {
+        th->join();
+    }
+    logger->clearAppenders();
+
+    uint64_t total = countLines("reload_a.log") + countLines("reload_b.log");
+    std::cout << "reloads=" << reloads << " expect=" << s_thread_count * s_log_count
+              << " total=" << total << std::endl;
+    FL_ASSERT(total == (uint64_t)s_thread_count * s_log_count);
+    return total == (uint64_t)s_thread_count * s_log_count ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#include "../src/FL_LogManager.h"
+#include "../src/FL_Thread.h"
+#include "../src/FL/macro.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+static const int s_thread_count = 4;
+static const int s_record_count = 2000;
+
+// 多线程写入环形缓冲区, 返回导出的日志
+static std::string WriteAndDump(const std::string& file, uint64_t size) {
+    unlink(file.c_str());
+    FL::Logger::ptr logger = FL_LOG_NAME("ring");
+    FL::MmapRingLogAppender::ptr ring(new FL::MmapRingLogAppender(file, size));
+    FL_ASSERT(ring->isValid());
+    ring->setFormatter(std::make_shared<FL::LogFormatter>("%m%n"));
+    logger->setAppenders({ring});
+
+    std::vector<FL::Thread::ptr> threads;
+    for(int i = 0 ; i < s_thread_count ; ++i) {
+        threads.push_back(std::make_shared<FL::Thread>("ring_" + std::to_string(i), [logger, i]() {
+            for(int j = 0 ; j < s_record_count ; ++j) {
+                FL_LOG_INFO(logger) << "ring t=" << i << " j=" << j;
+            }
+        }));
+    }
+    for(auto& th : threads) {
+        th->join();
+    }
+    logger->clearAppenders();
+
+    std::stringstream ss;
+    FL_ASSERT(FL::MmapRingLogAppender::Dump(file, ss));
+    return ss.str();
+}
+
+// 检查每条日志完整, 每个线程的日志按顺序且连续, 以该线程最后一条结束; 返回导出的条数.
+// 回绕后先结束的线程的日志可能全部被覆盖
+static int CheckDump(const std::string& dump) {
+    std::vector<int> first(s_thread_count, -1);
+    std::vector<int> last(s_thread_count, -1);
+    std::istringstream is(dump);
+    std::string line;
+    int count = 0;
+    while(std::getline(is, line)) {
+        int t = -1;
+        int j = -1;
+        int n = 0;
+        FL_ASSERT(sscanf(line.c_str(), "ring t=%d j=%d%n", &t, &j, &n) == 2);
+        FL_ASSERT(n == (int)line.size());
+        FL_ASSERT(t >= 0 && t < s_thread_count && j >= 0 && j < s_record_count);
+        if(first[t] < 0) {
+            first[t] = j;
+        } else {
+            FL_ASSERT(j == last[t] + 1);
+        }
+        last[t] = j;
+        ++count;
+    }
+    for(int t = 0 ; t < s_thread_count ; ++t) {
+        FL_ASSERT(last[t] == -1 || last[t] == s_record_count - 1);
+    }
+    return count;
+}
+
+// 缓冲区足够大时所有日志都能导出
+static void test_all_records(const std::string& file) {
+    std::string dump = WriteAndDump(file, 4 * 1024 * 1024);
+    FL_ASSERT(CheckDump(dump) == s_thread_count * s_record_count);
+}
+
+// 缓冲区回绕后只保留最近的一段日志
+static void test_wrap(const std::string& file) {
+    std::string dump = WriteAndDump(file, 64 * 1024);
+    int count = CheckDump(dump);
+    FL_ASSERT(count > 0 && count < s_thread_count * s_record_count);
+    // 每条记录连同头部不超过48字节, 导出的记录至少占缓冲区的一半
+    FL_ASSERT(count * 48 > 32 * 1024);
+}
+
+// 头部完整而内容被改写的记录不会被导出
+static void test_corrupt(const std::string& file) {
+    std::string dump = WriteAndDump(file, 4 * 1024 * 1024);
+    std::string victim = "ring t=1 j=1999\n";
+    FL_ASSERT(dump.find(victim) != std::string::npos);
+
+    std::string data;
+    {
+        std::ifstream ifs(file, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    size_t pos = data.find(victim);
+    FL_ASSERT(pos != std::string::npos);
+    data[pos + victim.size() - 2] = '8';
+    {
+        std::fstream fs(file, std::ios::binary | std::ios::in | std::ios::out);
+        fs.seekp(pos);
+        fs.write(data.c_str() + pos, victim.size());
+    }
+
+    std::stringstream ss;
+    FL_ASSERT(FL::MmapRingLogAppender::Dump(file, ss));
+    // 只少了被改写的一条, 其余日志不受影响
+    dump.erase(dump.find(victim), victim.size());
+    FL_ASSERT(ss.str() == dump);
+}
+
+// 用法: exampleRingLog            测试写入和导出
+//       exampleRingLog <file>     导出崩溃后遗留的环形缓冲区文件
+int main(int argc, char** argv) {
+    if(argc > 1) {
+        return FL::MmapRingLogAppender::Dump(argv[1], std::cout) ? 0 : 1;
+    }
+
+    std::string file = "/tmp/fl_ring_" + std::to_string(getpid()) + ".log";
+    test_all_records(file);
+    test_wrap(file);
+    test_corrupt(file);
+    unlink(file.c_str());
+    std::cout << "ring log ok" << std::endl;
+    return 0;
+}
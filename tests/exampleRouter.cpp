@@ -0,0 +1,140 @@
+#include "../src/FL/http/http_servlet.h"
+#include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+#include "../src/FL/util.h"
+
+#include <fnmatch.h>
+
+auto lg = FL_LOG_ROOT();
+
+using namespace FL::http;
+
+static Servlet::ptr MakeServlet(const std::string& name) {
+    return FunctionServlet::ptr(new FunctionServlet([name](HttpRequest::ptr
+                                , HttpResponse::ptr rsp, HttpSession::ptr) {
+        rsp->setBody(name);
+        return 0;
+    }));
+}
+
+void test_match() {
+    ServletDispatch sd;
+    auto exact = MakeServlet("exact");
+    auto user = MakeServlet("user");
+    auto posts = MakeServlet("posts");
+    auto files = MakeServlet("files");
+    auto prefix = MakeServlet("prefix");
+    auto html = MakeServlet("html");
+
+    sd.addServlet("/user/me", exact);
+    FL_ASSERT(sd.addRoute("/user/:id", user));
+    FL_ASSERT(sd.addRoute("/user/:id/posts/:pid", posts));
+    FL_ASSERT(sd.addRoute("/files/*path", files));
+    FL_ASSERT(!sd.addRoute("/user/:uid/x", user));
+    FL_ASSERT(!sd.addRoute("/a/*/b", user));
+    sd.addGlobServlet("/static/*", prefix);
+    sd.addGlobServlet("/static/*.html", html);
+
+    RadixRouter::Params params;
+    FL_ASSERT(sd.getMatchServlet("/user/me", &params) == exact && params.empty());
+    FL_ASSERT(sd.getMatchServlet("/user/42", &params) == user);
+    FL_ASSERT(params.size() == 1 && params[0].first == "id" && params[0].second == "42");
+    params.clear();
+    FL_ASSERT(sd.getMatchServlet("/user/42/posts/7", &params) == posts);
+    FL_ASSERT(params.size() == 2 && params[1].first == "pid" && params[1].second == "7");
+    params.clear();
+    FL_ASSERT(sd.getMatchServlet("/files/a/b.txt", &params) == files);
+    FL_ASSERT(params.size() == 1 && params[0].second == "a/b.txt");
+    FL_ASSERT(sd.getMatchServlet("/static/js/app.js") == prefix);
+    FL_ASSERT(sd.getMatchServlet("/static/index.html") == html);
+    FL_ASSERT(sd.getMatchServlet("/user/") == sd.getDefault());
+    FL_ASSERT(sd.getMatchServlet("/nothing") == sd.getDefault());
+
+    sd.delRoute("/user/:id");
+    FL_ASSERT(sd.getMatchServlet("/user/42") == sd.getDefault());
+    FL_ASSERT(sd.getMatchServlet("/user/42/posts/7") == posts);
+
+    // handle把参数写入请求
+    HttpRequest::ptr req(new HttpRequest);
+    HttpResponse::ptr rsp(new HttpResponse);
+    req->setPath("/user/9/posts/3");
+    sd.handle(req, rsp, nullptr);
+    FL_ASSERT(rsp->getBody() == "posts" && req->getParam("id") == "9" && req->getParam("pid") == "3");
+}
+
+// glob之间的优先级: 其它glob先于前缀glob, 与添加顺序无关; 前缀glob之间最长前缀优先
+void test_glob_precedence() {
+    ServletDispatch sd;
+    auto any = MakeServlet("any");
+    auto api = MakeServlet("api");
+    auto json = MakeServlet("json");
+    auto qmark = MakeServlet("qmark");
+
+    sd.addGlobServlet("/api/*", any);
+    sd.addGlobServlet("/api/v1/*", api);
+    sd.addGlobServlet("/api/*.json", json);
+    FL_ASSERT(sd.getMatchServlet("/api/x") == any);
+    FL_ASSERT(sd.getMatchServlet("/api/v1/x") == api);
+    // 先添加的前缀glob不会挡住后添加的其它glob
+    FL_ASSERT(sd.getMatchServlet("/api/v1/x.json") == json);
+
+    // 其它glob之间仍按添加顺序
+    sd.addGlobServlet("/api/v?/*", qmark);
+    FL_ASSERT(sd.getMatchServlet("/api/v2/a.json") == json);
+    FL_ASSERT(sd.getMatchServlet("/api/v2/a") == qmark);
+    sd.delGlobServlet("/api/*.json");
+    FL_ASSERT(sd.getMatchServlet("/api/v2/a.json") == qmark);
+
+    // 精确路由和参数路由先于所有glob
+    auto exact = MakeServlet("exact");
+    sd.addServlet("/api/v1/x.json", exact);
+    FL_ASSERT(sd.getMatchServlet("/api/v1/x.json") == exact);
+    FL_ASSERT(sd.addRoute("/api/v1/:name", exact));
+    FL_ASSERT(sd.getMatchServlet("/api/v1/y") == exact);
+    FL_ASSERT(sd.getMatchServlet("/api/v1/y/z") == qmark);
+}
+
+void bench_match() {
+    const int N = 800;
+    const int LOOP = 200000;
+    ServletDispatch sd;
+    std::vector<std::string> globs;
+    auto slt = MakeServlet("x");
+    for(int i = 0; i < N; ++i) {
+        std::string glob = "/api/v1/service" + std::to_string(i) + "/*";
+        sd.addGlobServlet(glob, slt);
+        globs.push_back(glob);
+    }
+
+    std::vector<std::string> paths;
+    for(int i = 0; i < 64; ++i) {
+        paths.push_back("/api/v1/service" + std::to_string(i * 12 + 5) + "/items/123");
+    }
+
+    uint64_t start = FL::UT::GetCurrentUs();
+    size_t hit = 0;
+    for(int i = 0; i < LOOP; ++i) {
+        hit += sd.getMatchServlet(paths[i & 63]) == slt;
+    }
+    uint64_t radix = FL::UT::GetCurrentUs() - start;
+
+    start = FL::UT::GetCurrentUs();
+    for(int i = 0; i < LOOP / 100; ++i) {
+        for(auto& g : globs) {
+            if(!fnmatch(g.c_str(), paths[i & 63].c_str(), 0)) {
+                ++hit;
+                break;
+            }
+        }
+    }
+    uint64_t linear = (FL::UT::GetCurrentUs() - start) * 100;
+    FL_LOG_INFO(lg) << N << " routes, " << LOOP << " lookups: radix " << radix / 1000
+                    << "ms, linear fnmatch ~" << linear / 1000 << "ms, hit=" << hit;
+}
+
+int main(int argc, char** argv) {
+    test_match();
+    test_glob_precedence();
+    bench_match();
+    return 0;
+}
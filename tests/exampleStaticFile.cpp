@@ -0,0 +1,221 @@
+#include "../src/FL/http/http_server.h"
+#include "../src/FL/http/static_file_servlet.h"
+#include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+#include <fstream>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+auto lg = FL_LOG_ROOT();
+
+static const char* s_addr = "127.0.0.1:18942";
+static std::string g_root;
+
+struct Response {
+    int status = 0;
+    std::string head;
+    std::string body;
+
+    std::string header(const char* name) const {
+        std::string key = std::string("\r\n") + name + ": ";
+        const char* p = strcasestr(head.c_str(), key.c_str());
+        if(!p) {
+            return "";
+        }
+        p += key.size();
+        return std::string(p, strstr(p, "\r\n") - p);
+    }
+};
+
+static void WriteFile(const std::string& name, const std::string& data) {
+    std::ofstream ofs(g_root + "/" + name, std::ios::trunc);
+    ofs << data;
+}
+
+static FL::Socket::ptr Connect() {
+    FL::Address::ptr addr = FL::Address::LookupAnyIPAddress(s_addr);
+    FL::Socket::ptr sock = FL::Socket::CreateTCP(addr);
+    FL_ASSERT(sock->connect(addr));
+    sock->setRecvTimeout(2000);
+    return sock;
+}
+
+// 在keep-alive连接上发送一个请求并读取完整响应, HEAD和304没有消息体
+static Response Request(FL::Socket::ptr sock, const std::string& method
+                        , const std::string& path, const std::string& headers = "") {
+    std::string req = method + " " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n" + headers + "\r\n";
+    FL_ASSERT(sock->send(req.c_str(), req.size(), MSG_NOSIGNAL) == (int)req.size());
+
+    Response rsp;
+    std::string data;
+    char buf[4096];
+    size_t pos;
+    while((pos = data.find("\r\n\r\n")) == std::string::npos) {
+        int rt = sock->recv(buf, sizeof(buf));
+        FL_ASSERT(rt > 0);
+        data.append(buf, rt);
+    }
+    rsp.head = data.substr(0, pos + 2);
+    rsp.status = atoi(rsp.head.c_str() + 9);
+    size_t length = 0;
+    if(method != "HEAD" && rsp.status != 304) {
+        length = strtoull(rsp.header("content-length").c_str(), nullptr, 10);
+    }
+    rsp.body = data.substr(pos + 4);
+    while(rsp.body.size() < length) {
+        int rt = sock->recv(buf, sizeof(buf));
+        FL_ASSERT(rt > 0);
+        rsp.body.append(buf, rt);
+    }
+    // 响应之后不能有多余的数据, 否则连接上的后续响应会错位
+    FL_ASSERT(rsp.body.size() == length);
+    return rsp;
+}
+
+static void test_get_head(FL::Socket::ptr sock) {
+    Response rsp = Request(sock, "GET", "/static/hello.txt");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "0123456789");
+    FL_ASSERT(rsp.header("content-type") == "text/plain");
+    FL_ASSERT(!rsp.header("etag").empty() && !rsp.header("last-modified").empty());
+
+    rsp = Request(sock, "HEAD", "/static/hello.txt");
+    FL_ASSERT(rsp.status == 200 && rsp.body.empty());
+    FL_ASSERT(rsp.header("content-length") == "10");
+
+    rsp = Request(sock, "GET", "/static/dir/");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "<html></html>");
+    FL_ASSERT(rsp.header("content-type") == "text/html");
+
+    rsp = Request(sock, "POST", "/static/hello.txt", "content-length: 0\r\n");
+    FL_ASSERT(rsp.status == 405);
+    FL_LOG_INFO(lg) << "get/head ok";
+}
+
+static void test_conditional(FL::Socket::ptr sock) {
+    Response full = Request(sock, "GET", "/static/hello.txt");
+    std::string etag = full.header("etag");
+    std::string last_modified = full.header("last-modified");
+
+    Response rsp = Request(sock, "GET", "/static/hello.txt", "If-None-Match: " + etag + "\r\n");
+    FL_ASSERT(rsp.status == 304 && rsp.body.empty());
+    rsp = Request(sock, "GET", "/static/hello.txt", "If-None-Match: \"other\"\r\n");
+    FL_ASSERT(rsp.status == 200);
+
+    rsp = Request(sock, "GET", "/static/hello.txt", "If-Modified-Since: " + last_modified + "\r\n");
+    FL_ASSERT(rsp.status == 304);
+    rsp = Request(sock, "GET", "/static/hello.txt"
+                  , "If-Modified-Since: Thu, 01 Jan 1970 00:00:00 GMT\r\n");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "0123456789");
+    FL_LOG_INFO(lg) << "conditional ok";
+}
+
+static void test_range(FL::Socket::ptr sock) {
+    Response rsp = Request(sock, "GET", "/static/hello.txt", "Range: bytes=2-5\r\n");
+    FL_ASSERT(rsp.status == 206 && rsp.body == "2345");
+    FL_ASSERT(rsp.header("content-range") == "bytes 2-5/10");
+
+    rsp = Request(sock, "GET", "/static/hello.txt", "Range: bytes=7-\r\n");
+    FL_ASSERT(rsp.status == 206 && rsp.body == "789");
+    rsp = Request(sock, "GET", "/static/hello.txt", "Range: bytes=-3\r\n");
+    FL_ASSERT(rsp.status == 206 && rsp.body == "789");
+    rsp = Request(sock, "GET", "/static/hello.txt", "Range: bytes=5-100\r\n");
+    FL_ASSERT(rsp.status == 206 && rsp.body == "56789");
+
+    rsp = Request(sock, "GET", "/static/hello.txt", "Range: bytes=10-\r\n");
+    FL_ASSERT(rsp.status == 416 && rsp.body.empty());
+    FL_ASSERT(rsp.header("content-range") == "bytes */10");
+
+    // 多区间不支持, 返回整个文件
+    rsp = Request(sock, "GET", "/static/hello.txt", "Range: bytes=0-1,3-4\r\n");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "0123456789");
+
+    std::string etag = rsp.header("etag");
+    rsp = Request(sock, "GET", "/static/hello.txt", "Range: bytes=0-0\r\nIf-Range: " + etag + "\r\n");
+    FL_ASSERT(rsp.status == 206 && rsp.body == "0");
+    rsp = Request(sock, "GET", "/static/hello.txt", "Range: bytes=0-0\r\nIf-Range: \"stale\"\r\n");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "0123456789");
+    FL_LOG_INFO(lg) << "range ok";
+}
+
+static void test_path(FL::Socket::ptr sock) {
+    Response rsp = Request(sock, "GET", "/static/../secret.txt");
+    FL_ASSERT(rsp.status == 404);
+    rsp = Request(sock, "GET", "/static/dir/../../secret.txt");
+    FL_ASSERT(rsp.status == 404);
+    rsp = Request(sock, "GET", "/static/..");
+    FL_ASSERT(rsp.status == 404);
+    rsp = Request(sock, "GET", "/static/a..b.txt");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "dots");
+    rsp = Request(sock, "GET", "/static/missing.txt");
+    FL_ASSERT(rsp.status == 404);
+    FL_LOG_INFO(lg) << "path ok";
+}
+
+static void test_file_changed(FL::Socket::ptr sock) {
+    Response old_rsp = Request(sock, "GET", "/static/change.txt");
+    FL_ASSERT(old_rsp.status == 200 && old_rsp.body == "old");
+
+    // 缓存项在检查间隔内不会重新stat, 之后应发现文件变化
+    WriteFile("pub/change.txt", "new content");
+    usleep(150 * 1000);
+    Response rsp = Request(sock, "GET", "/static/change.txt");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "new content");
+    FL_ASSERT(rsp.header("etag") != old_rsp.header("etag"));
+    rsp = Request(sock, "GET", "/static/change.txt", "If-None-Match: " + old_rsp.header("etag") + "\r\n");
+    FL_ASSERT(rsp.status == 200);
+
+    // 文件被删除后不再返回缓存的内容
+    unlink((g_root + "/pub/change.txt").c_str());
+    usleep(150 * 1000);
+    rsp = Request(sock, "GET", "/static/change.txt");
+    FL_ASSERT(rsp.status == 404);
+
+    // 不缓存时每次都重新打开
+    WriteFile("change.txt", "nocache");
+    rsp = Request(sock, "GET", "/nocache/change.txt");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "nocache");
+    WriteFile("change.txt", "nocache 2");
+    rsp = Request(sock, "GET", "/nocache/change.txt");
+    FL_ASSERT(rsp.status == 200 && rsp.body == "nocache 2");
+    FL_LOG_INFO(lg) << "file changed ok";
+}
+
+void task() {
+    FL::http::HttpServer::ptr server(new FL::http::HttpServer(true));
+    FL_ASSERT(server->bind(FL::Address::LookupAnyIPAddress(s_addr)));
+    auto sd = server->getServletDispath();
+    sd->addGlobServlet("/static/*", FL::http::StaticFileServlet::ptr(
+                           new FL::http::StaticFileServlet(g_root + "/pub", "/static/", 1024, 100)));
+    sd->addGlobServlet("/nocache/*", FL::http::StaticFileServlet::ptr(
+                           new FL::http::StaticFileServlet(g_root, "/nocache/", 0)));
+    server->start();
+
+    auto sock = Connect();
+    test_get_head(sock);
+    test_conditional(sock);
+    test_range(sock);
+    test_path(sock);
+    test_file_changed(sock);
+    server->stop();
+}
+
+int main(int argc, char** argv) {
+    char tmpl[] = "/tmp/fl_static_XXXXXX";
+    FL_ASSERT(mkdtemp(tmpl));
+    g_root = tmpl;
+    WriteFile("secret.txt", "secret");
+    FL_ASSERT(mkdir((g_root + "/pub").c_str(), 0755) == 0);
+    FL_ASSERT(mkdir((g_root + "/pub/dir").c_str(), 0755) == 0);
+    WriteFile("pub/hello.txt", "0123456789");
+    WriteFile("pub/a..b.txt", "dots");
+    WriteFile("pub/dir/index.html", "<html></html>");
+    WriteFile("pub/change.txt", "old");
+
+    {
+        FL::IOManager iom(2);
+        iom.schedule(task);
+    }
+    system(("rm -rf " + g_root).c_str());
+    return 0;
+}
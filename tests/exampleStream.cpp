@@ -0,0 +1,103 @@
+#include "../src/FL/stream_decorator.h"
+#include "../src/FL/logmanager.h"
+#include "../src/FL/macro.h"
+
+auto lg = FL_LOG_ROOT();
+
+// 内存流, 统计底层读写次数
+class MemStream : public FL::Stream {
+  public:
+    typedef std::shared_ptr<MemStream> ptr;
+
+    MemStream(const std::string& data = "")
+        : m_data(data) {
+    }
+
+    int read(void* buffer, size_t length) override {
+        ++m_reads;
+        size_t len = std::min(length, m_data.size() - m_pos);
+        memcpy(buffer, m_data.c_str() + m_pos, len);
+        m_pos += len;
+        return len;
+    }
+    int read(FL::ByteArray::ptr byte_arr, size_t length) override {
+        std::string buf(length, 0);
+        int rt = read(&buf[0], length);
+        byte_arr->write(buf.c_str(), rt);
+        return rt;
+    }
+    int write(const void* buffer, size_t length) override {
+        ++m_writes;
+        m_out.append((const char*)buffer, length);
+        return length;
+    }
+    int write(FL::ByteArray::ptr byte_arr, size_t length) override {
+        std::string buf(length, 0);
+        byte_arr->read(&buf[0], length);
+        return write(buf.c_str(), length);
+    }
+    void close() override {}
+
+    std::string m_data;
+    std::string m_out;
+    size_t m_pos = 0;
+    int m_reads = 0;
+    int m_writes = 0;
+};
+
+void test_buffered_read() {
+    std::string text;
+    for(int i = 0; i < 1000; ++i) {
+        text += "line " + std::to_string(i) + "\r\n";
+    }
+    text += "tail";
+    MemStream::ptr mem(new MemStream(text));
+    FL::BufferedReadStream::ptr rs(new FL::BufferedReadStream(mem, 64));
+
+    char head[4];
+    FL_ASSERT(rs->peek(head, 4) == 4 && memcmp(head, "line", 4) == 0);
+    std::string line;
+    for(int i = 0; i < 1000; ++i) {
+        FL_ASSERT(rs->readLine(line) > 0);
+        FL_ASSERT(line == "line " + std::to_string(i));
+    }
+    FL_ASSERT(rs->readLine(line) == 0);
+    FL_ASSERT(rs->available() == 4);
+    FL_LOG_INFO(lg) << "buffered read: 1000 lines in " << mem->m_reads << " reads";
+}
+
+void test_buffered_write() {
+    MemStream::ptr mem(new MemStream);
+    FL::BufferedWriteStream::ptr ws(new FL::BufferedWriteStream(mem, 1024));
+    std::string expect;
+    for(int i = 0; i < 1000; ++i) {
+        std::string s = "k" + std::to_string(i) + "=v;";
+        ws->write(s.c_str(), s.size());
+        expect += s;
+    }
+    std::string big(5000, 'b');
+    ws->write(big.c_str(), big.size());
+    expect += big;
+    FL_ASSERT(ws->flush());
+    FL_ASSERT(mem->m_out == expect);
+    FL_LOG_INFO(lg) << "buffered write: " << expect.size() << " bytes in " << mem->m_writes << " writes";
+}
+
+void test_limited_tee() {
+    MemStream::ptr mem(new MemStream("0123456789abcdef"));
+    MemStream::ptr copy(new MemStream);
+    FL::TeeStream::ptr tee(new FL::TeeStream(mem, copy));
+    FL::LimitedStream::ptr ls(new FL::LimitedStream(tee, 10));
+    char buf[32];
+    FL_ASSERT(ls->readFixSize(buf, 10) == 10);
+    FL_ASSERT(ls->read(buf, sizeof(buf)) == 0);
+    FL_ASSERT(copy->m_out == "0123456789");
+    FL_LOG_INFO(lg) << "limited/tee ok";
+}
+
+int main(int argc, char** argv) {
+    test_buffered_read();
+    test_buffered_write();
+    test_limited_tee();
+    return 0;
+}